@@ -11,23 +11,22 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <queue>
 #include "MainComponent.h"
+#include "AnalysisEngine.h"
+#include "ParametricEqFitter.h"
 
 //==============================================================================
 class AnalyserComponent : public juce::AudioAppComponent,
-    private juce::Timer,
     public juce::Button::Listener,
-    public juce::Slider::Listener
+    public juce::Slider::Listener,
+    public juce::ComboBox::Listener
 {
 public:
     AnalyserComponent()
-        : forwardFFT(fftOrder),
-        forwardFFT2(fftOrder),
-        window(fftSize, juce::dsp::WindowingFunction<float>::hann)
-
     {
         setOpaque(true);
-        startTimer(50);
+        std::fill(std::begin(pointColours), std::end(pointColours), juce::Colours::royalblue);
         setSize(700, 500);
 
         // Add buttons and sliders
@@ -56,7 +55,7 @@ public:
         resetPhButton.addListener(this);
 
         addAndMakeVisible(maxClustersSlider);
-        maxClustersSlider.setRange(1, 5, 1); // Range from 1 to 5, with step size of 1
+        maxClustersSlider.setRange(1, numFittedBands, 1); // One filter per fitted main bus EQ band
         maxClustersSlider.setSliderStyle(juce::Slider::LinearHorizontal);
         maxClustersSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 20);
         maxClustersSlider.setValue(5); // Default value
@@ -78,6 +77,41 @@ public:
         showThresholdButton.setButtonText("Show Threshold");
         showThresholdButton.addListener(this);
 
+        addAndMakeVisible(coherenceGateButton);
+        coherenceGateButton.setButtonText("Coherence gate");
+        coherenceGateButton.setToggleState(true, juce::dontSendNotification);
+        coherenceGateButton.addListener(this);
+
+        addAndMakeVisible(overlapBox);
+        overlapBox.addItem("No overlap", 1);
+        overlapBox.addItem("50% overlap", 2);
+        overlapBox.addItem("75% overlap", 3);
+        overlapBox.addItem("87.5% overlap", 4);
+        overlapBox.setSelectedId(3); // Default value
+        overlapBox.addListener(this);
+        engine.setOverlap(0.75f);
+
+        addAndMakeVisible(smoothingBox);
+        smoothingBox.addItem("No smoothing", 1);
+        for (int i = 1; i < juce::numElementsInArray(smoothingFractions); ++i)
+            smoothingBox.addItem("1/" + juce::String(smoothingFractions[i]) + " octave", i + 1);
+        smoothingBox.setSelectedId(1); // Default value
+        smoothingBox.addListener(this);
+
+        addAndMakeVisible(averagingBox);
+        averagingBox.addItem("FIFO average", 1);
+        averagingBox.addItem("Exponential", 2);
+        averagingBox.addItem("Infinite", 3);
+        averagingBox.setSelectedId(1); // Default value
+        averagingBox.addListener(this);
+
+        addAndMakeVisible(averageDepthSlider);
+        averageDepthSlider.setSliderStyle(juce::Slider::LinearBar);
+        averageDepthSlider.setRange(1, TransferFunctionEstimator::maxAverageDepth, 1);
+        averageDepthSlider.setTextValueSuffix(" frames");
+        averageDepthSlider.setValue(AnalysisEngine::averageNumber); // Default value
+        averageDepthSlider.addListener(this);
+
     }
 
     ~AnalyserComponent() override
@@ -87,7 +121,10 @@ public:
 
     //==============================================================================
 
-    void prepareToPlay(int, double) override {}
+    void prepareToPlay(int, double sampleRate) override
+    {
+        engine.prepare(sampleRate);
+    }
     void releaseResources() override {}
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override {}
 
@@ -96,17 +133,54 @@ public:
     // JUCE GUI functions ==========================================================
     void paint(juce::Graphics& g) override
     {
-        g.fillAll(juce::Colours::black);
-        g.fillAll(juce::Colour::fromRGB(15, 15, 15));
-        g.setColour(juce::Colour::fromRGB(45, 45, 45));
-        g.drawLine(0, getHeight() / 2 + 5, getWidth(), getHeight() / 2 + 5, 6);
+        // Background, grid and labels only change on resize, so they are
+        // rendered once into an image and just composited here
+        const float scale = juce::Component::getApproximateScaleFactorForComponent(this);
+        if (gridImage.isNull() || gridImageScale != scale)
+            renderGrid(scale);
+
+        g.drawImage(gridImage, getLocalBounds().toFloat());
         g.setOpacity(1.0f);
         g.setColour(juce::Colours::white);
+
+        // Traces stay out from under the controls, so a new frame never has
+        // to repaint them
+        juce::Graphics::ScopedSaveState state(g);
+        g.reduceClipRegion(traceArea);
         drawFrame(g,mode);
     }
 
+    // Renders everything that doesn't depend on the data into gridImage, at
+    // the display's pixel scale so the labels stay sharp
+    void renderGrid(float scale)
+    {
+        gridImageScale = scale;
+        gridImage = juce::Image(juce::Image::RGB, juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                                juce::jmax(1, juce::roundToInt(getHeight() * scale)), false);
+
+        juce::Graphics g(gridImage);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        g.fillAll(juce::Colour::fromRGB(15, 15, 15));
+        g.setColour(juce::Colour::fromRGB(45, 45, 45));
+        g.drawLine(0, getHeight() / 2 + 5, getWidth(), getHeight() / 2 + 5, 6);
+
+        if (mode == 1)
+        {
+            auto width = getLocalBounds().getWidth();
+            auto height = getLocalBounds().getHeight() / 2;
+
+            g.setColour(juce::Colours::white);
+            drawFrequencyScale(g, width, height);
+            drawAmplitudeScale(g, width, height);
+            drawFrequencyScale(g, width, height * 2);
+            drawPhaseScale(g, width, height);
+        }
+    }
+
     // Set position and size of buttons and sliders
     void resized() override {
+        gridImage = {};
         detectButton.setBounds(getWidth() - 330, 10, 100, 30);
 		applyButton.setBounds(getWidth() - 220, 10, 100, 30);
         resetButton.setBounds(getWidth() - 110, 10, 100, 30);
@@ -117,6 +191,25 @@ public:
         maxClustersLabel.setBounds(getWidth() - 655, 17, 100, 30);
 		thresholdSlider.setBounds(0, 0, 30, getHeight() / 4);
         showThresholdButton.setBounds(60, 0, 100, 30);
+
+        // Analysis settings, along the top of the phase plot
+        overlapBox.setBounds(70, getHeight() / 2 + 14, 100, 22);
+        smoothingBox.setBounds(175, getHeight() / 2 + 14, 100, 22);
+        averagingBox.setBounds(280, getHeight() / 2 + 14, 100, 22);
+        averageDepthSlider.setBounds(385, getHeight() / 2 + 14, 100, 22);
+        coherenceGateButton.setBounds(490, getHeight() / 2 + 10, 110, 30);
+        updateTraceArea();
+    }
+
+    // The part of the component the traces are drawn in: everything not
+    // covered by a visible control. This is the only region invalidated when
+    // a new frame arrives.
+    void updateTraceArea()
+    {
+        traceArea = getLocalBounds();
+        for (auto* child : getChildren())
+            if (child->isVisible())
+                traceArea.subtract(child->getBounds());
     }
 
     // Manage button clicks
@@ -133,6 +226,10 @@ public:
         {
 			magnitudeDetected = false;
 			clusters.clear();
+            fittedEq = {};
+            eqPreview.clear();
+            showPrediction = false;
+            updateClusterColours();
             OSCEngine->OSCSender.resetStEq();
 		}
         else if (button == &showThresholdButton)
@@ -147,7 +244,14 @@ public:
 				thresholdSlider.setVisible(false);
                 showThreshold = false;
 			}
+            updateTraceArea();
+            repaint();
 		}
+        else if (button == &coherenceGateButton)
+        {
+            coherenceGate = coherenceGateButton.getToggleState();
+            repaint();
+        }
     };
 
     // Manage slider changes
@@ -160,198 +264,81 @@ public:
         {
             clusterThreshold = thresholdSlider.getValue();
         }
+        else if (slider == &averageDepthSlider)
+        {
+            updateAveraging();
+        }
     };
 
-    // END OF JUCE GUI functions ===================================================
-
-    // FFT functions ===============================================================
-    // Timer that manages when to draw the next frame of the spectrum
-    void timerCallback() override
-    {
-        if (nextFFTBlockReady)
+    // Manage combo box changes
+    void comboBoxChanged(juce::ComboBox* comboBox) override {
+        if (comboBox == &overlapBox)
         {
-            drawNextFrameOfSpectrum(mode);
-            nextFFTBlockReady = false;
-            repaint();
+            const float overlaps[] = { 0.0f, 0.5f, 0.75f, 0.875f };
+            engine.setOverlap(overlaps[juce::jlimit(0, 3, overlapBox.getSelectedItemIndex())]);
         }
-    }
-
-    // FIFO buffer for single channel mode (not in use)
-    void pushNextSampleIntoFifo(float sample) noexcept
-    {
-        // if the fifo contains enough data, set a flag to say
-        // that the next frame should now be rendered..
-        if (fifoIndex == fftSize)
+        else if (comboBox == &smoothingBox)
         {
-            if (!nextFFTBlockReady)
-            {
-                juce::zeromem(fftData, sizeof(fftData));
-                memcpy(fftData, fifo, sizeof(fifo));
-                nextFFTBlockReady = true;
-            }
-            fifoIndex = 0;
+            const int index = juce::jlimit(0, juce::numElementsInArray(smoothingFractions) - 1, smoothingBox.getSelectedItemIndex());
+            engine.setSmoothing(smoothingFractions[index]);
         }
-        fifo[fifoIndex++] = sample;
-    }
-
-    // FIFO buffer for dual channel mode
-    void pushNextSampleIntoFifo(float sample, float sample2) noexcept
-    {
-        // if the fifo contains enough data, set a flag to say
-        // that the next frame should now be rendered..
-        if (fifoIndex == fftSize)
+        else if (comboBox == &averagingBox)
         {
-            if (!nextFFTBlockReady)
-            {
-                juce::zeromem(fftData, sizeof(fftData));
-                juce::zeromem(fftData2, sizeof(fftData2));
-                juce::zeromem(fftInput, sizeof(fftInput)); // !
-                juce::zeromem(fftInput2, sizeof(fftInput2)); // !
-                //memcpy(fftData, fifo, sizeof(fifo));
-                //memcpy(fftData2, fifo2, sizeof(fifo2));
-                for (int i = 0; i < fftSize; ++i) // ---------------------!
-                {
-                    fftInput[i] = std::complex<float>(fifo[i], 0.0f);
-                    fftInput2[i] = std::complex<float>(fifo2[i], 0.0f);
-                } // ----------------------------------------------------!
-                nextFFTBlockReady = true;
-            }
-            fifoIndex = 0;
+            updateAveraging();
         }
-        fifo[fifoIndex] = sample;
-        fifo2[fifoIndex] = sample2;
-        fifoIndex++;
-    }
+    };
 
-    void drawNextFrameOfSpectrum(int mode = 0)
+    void updateAveraging()
     {
-        // Single channel mode (not in use)
-        //if (mode == 0)
-        //{
-        //    // First apply a windowing function to our data
-        //    window.multiplyWithWindowingTable(fftData, fftSize);
-
-        //    // Then render our FFT data
-        //    forwardFFT.performFrequencyOnlyForwardTransform(fftData);
-
-        //    auto mindB = -100.0f;
-        //    auto maxdB = 0.0f;
-
-        //    for (int i = 0; i < scopeSize; ++i)
-        //    {
-        //        auto skewedProportionX = 1.0f - std::exp(std::log(1.0f - (float)i / (float)scopeSize) * 0.2f);
-        //        auto fftDataIndex = juce::jlimit(0, fftSize / 2, (int)(skewedProportionX * (float)fftSize * 0.5f));
-        //        auto level = juce::jmap(juce::jlimit(mindB, maxdB, juce::Decibels::gainToDecibels(fftData[fftDataIndex])
-        //            - juce::Decibels::gainToDecibels((float)fftSize)),
-        //            mindB, maxdB, 0.0f, 1.0f);
-
-        //        scopeData[i] = level;
-        //    }
-        //}
+        const TransferFunctionEstimator::Averaging modes[] = { TransferFunctionEstimator::Averaging::fifo,
+                                                               TransferFunctionEstimator::Averaging::exponential,
+                                                               TransferFunctionEstimator::Averaging::infinite };
+        engine.setAveraging(modes[juce::jlimit(0, 2, averagingBox.getSelectedItemIndex())], (int)averageDepthSlider.getValue());
+    }
 
-        // Dual channel mode
-        /*else*/ if (mode == 1) {
-            // First apply a windowing function to our data
-            //window.multiplyWithWindowingTable(fftData, fftSize);
-            //window.multiplyWithWindowingTable(fftData2, fftSize);
-            window.multiplyWithWindowingTable(reinterpret_cast<float*>(fftInput), fftSize); //!
-            window.multiplyWithWindowingTable(reinterpret_cast<float*>(fftInput2), fftSize);//!
-
-            // Then render our FFT data
-            //forwardFFT.performFrequencyOnlyForwardTransform(fftData);
-            //forwardFFT2.performFrequencyOnlyForwardTransform(fftData2);
-            forwardFFT.perform(fftInput, fftData, false);//!
-            forwardFFT2.perform(fftInput2, fftData2, false);//!
-
-            // Define min and max dB values
-            auto mindB = -60.0f;
-            auto maxdB = -40.0f;
-
-            // Define min and max frequencies
-            const float minFreq = 20.0f;
-            const float maxFreq = 20000.0f;
-            int sampleRate = 48000;
-
-            // Remap values from FFT data to the scope size
-            for (int i = 0; i < scopeSize; ++i)
-            {
-                float proportionX = (float)i / (float)scopeSize;
-                float logMinFreq = std::log10(minFreq);
-                float logMaxFreq = std::log10(maxFreq);
-                float logFreq = logMinFreq + proportionX * (logMaxFreq - logMinFreq);
-                float freq = std::pow(10, logFreq);
-
-                auto fftDataIndex = juce::jlimit(0, fftSize / 2, (int)((freq / (sampleRate / 2)) * (fftSize / 2)));
-
-                /*auto level = juce::jmap(juce::jlimit(mindB, maxdB,
-                    juce::Decibels::gainToDecibels(fftData[fftDataIndex]) -
-                    juce::Decibels::gainToDecibels((float)fftSize)),
-                    mindB, maxdB, 0.0f, 1.0f);*/ //----------------------!!!
-
-                auto level = juce::jmap(juce::jlimit(mindB, maxdB,
-                    juce::Decibels::gainToDecibels(std::abs(fftData[fftDataIndex])) -
-                    juce::Decibels::gainToDecibels((float)fftSize)),
-                    mindB, maxdB, 0.0f, 1.0f);
-
-                /*auto level2 = juce::jmap(juce::jlimit(mindB, maxdB,
-                    juce::Decibels::gainToDecibels(fftData2[fftDataIndex]) -
-                    juce::Decibels::gainToDecibels((float)fftSize)),
-                    mindB, maxdB, 0.0f, 1.0f);*/ //----------------------!!!
-
-                auto level2 = juce::jmap(juce::jlimit(mindB, maxdB,
-                    juce::Decibels::gainToDecibels(std::abs(fftData2[fftDataIndex])) -
-                    juce::Decibels::gainToDecibels((float)fftSize)),
-                    mindB, maxdB, 0.0f, 1.0f);
-
-                rtaMeasurement[i] = level;
-                rtaReference[i] = level2;
-
-                phaseDifference[i] = std::arg(fftData[fftDataIndex] / fftData2[fftDataIndex]); //!!!!!!!!!
-            }
-        }
+    // END OF JUCE GUI functions ===================================================
+
+    // FFT functions ===============================================================
+    // Called on every display refresh. Picks up the latest spectrum published
+    // by the analysis thread and repaints the traces only if there is one.
+    void vBlankCallback()
+    {
+        // Average only while the console shows the reference playing. With
+        // no meter stream (console not connected) nothing is gated.
+        const auto& meters = OSCEngine->meters;
+        engine.setSignalPresent(!meters.isReceiving()
+                                || juce::Decibels::gainToDecibels(meters.getBus(referenceBus)) >= signalPresencedB);
 
-        // Calculate relative magnitude
-        juce::FloatVectorOperations::subtract(magnitude, rtaMeasurement, rtaReference, scopeSize);
-        juce::FloatVectorOperations::add(magnitude, 1, scopeSize);
-        juce::FloatVectorOperations::multiply(magnitude, 0.5, scopeSize);
+        if (paused || !engine.updateFrame())
+            return;
 
-        juce::FloatVectorOperations::copy(phase, phaseDifference.data(), scopeSize);
+        const auto& frame = engine.getFrame();
+        juce::FloatVectorOperations::copy(averageMagnitudeOut, frame.magnitude, scopeSize);
+        juce::FloatVectorOperations::copy(averagePhaseOut, frame.phase, scopeSize);
+        juce::FloatVectorOperations::copy(averageCoherenceOut, frame.coherence, scopeSize);
+        std::copy(frame.feedback, frame.feedback + frame.numFeedback, feedbackRings);
+        numFeedbackRings = frame.numFeedback;
 
-        // Average magnitude and phase
-        averageMagnPhase();
+        for (const auto& area : traceArea)
+            repaint(area);
+    }
 
-        //maxMagnitude(); //Old function no longer used
+    // Stops the analysis altogether, e.g. while the window is minimised. The
+    // audio keeps flowing into the engine, which just discards it.
+    void setPaused(bool shouldBePaused)
+    {
+        paused = shouldBePaused;
+        engine.setPaused(shouldBePaused);
 
+        if (!paused)
+            repaint();
     }
 
-    void averageMagnPhase()
+    // Dual channel mode. Called from the audio thread once per device block:
+    // both channels are copied into the engine's lock-free FIFO.
+    void pushBlock(const float* meas, const float* ref, int numSamples) noexcept
     {
-        for (int i = 0; i < scopeSize; i++)
-        {
-            averageMagnitudeFifo.add(magnitude[i]);
-            averagePhaseFifo.add(phase[i]);
-        }
-        if (averageMagnitudeFifo.size() > averageFifoSize) {
-            for (int i = 0; i < scopeSize; ++i)
-		    {
-			    averageMagnitudeOut[i] = 0;
-                averagePhaseOut[i] = 0;
-			    for (int j = 0; j < averageNumber; ++j)
-			    {
-                    averageMagnitudeOut[i] = averageMagnitudeOut[i] + averageMagnitudeFifo[j * scopeSize + i];
-                    averagePhaseOut[i] = averagePhaseOut[i] + averagePhaseFifo[j * scopeSize + i];
-			    }
-                averageMagnitudeOut[i] /= averageNumber;
-                averagePhaseOut[i] /= averageNumber;
-		    }
-            for (int i = 0; i < scopeSize; ++i)
-            {
-                averageMagnitudeFifo.removeAndReturn(i); 
-                averagePhaseFifo.removeAndReturn(i);
-            }
-            //averageMagnitudeFifo.clear();
-            //averagePhaseFifo.clear();
-        } 
+        engine.pushBlock(meas, ref, numSamples);
     }
 
     // END OF FFT functions ========================================================
@@ -399,93 +386,168 @@ public:
         // Dual channel mode
         else if (mode == 1) {
 
-            // Draw grid
-            g.setColour(juce::Colours::white);
-            drawFrequencyScale(g, width, height);
-            drawAmplitudeScale(g, width, height);
-            drawFrequencyScale(g, width, height * 2);
-            drawPhaseScale(g, width, height);
+            if (freezed && newFreezedMagnitude) {
+                juce::FloatVectorOperations::copy(freezedMagnitude, averageMagnitudeOut, scopeSize);
+                newFreezedMagnitude = false;
+            }
+            if (freezed && newFreezedPhase) {
+                juce::FloatVectorOperations::copy(freezedPhase, averagePhaseOut, scopeSize);
+                newFreezedPhase = false;
+            }
 
+            const float pointWidth = (float)width / (float)(scopeSize - 1);
+            auto magnitudeY = [height](float value) { return juce::jmap(value, 0.0f, 1.0f, (float)height, 0.0f); };
+
+            // Draw the coherence, 0 at the bottom and 1 at the top of the magnitude plot
+            tracePath.clear();
+            tracePath.startNewSubPath(0.0f, magnitudeY(averageCoherenceOut[0]));
             for (int i = 1; i < scopeSize; ++i)
+                tracePath.lineTo((float)i * pointWidth, magnitudeY(averageCoherenceOut[i]));
+            g.setColour(juce::Colours::yellow.withAlpha(0.6f));
+            g.strokePath(tracePath, juce::PathStrokeType(1.0f));
+
+            // Draw the measurement curve as one path per run of the same
+            // cluster colour, blanked where it can't be trusted. Segment
+            // i-1 -> i takes the colour of point i-1.
+            for (int start = 0; start < scopeSize - 1;)
             {
-                // Set the color deppending on the cluster
-                juce::Colour colour = belongs2cluster(i - 1);
-                g.setColour(colour);
-
-                // Draw the measurement curve
-                float x1 = juce::jmap((float)(i - 1), 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                float y1 = juce::jmap(averageMagnitudeOut[i - 1], 0.0f, 1.0f, (float)height, 0.0f);
-                float x2 = juce::jmap((float)i, 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                float y2 = juce::jmap(averageMagnitudeOut[i], 0.0f, 1.0f, (float)height, 0.0f);
-                g.drawLine(x1, y1, x2, y2, 3);
-
-                // Draw freezed magnitude
-                if (freezed) {
-                    if (newFreezedMagnitude) {
-                        freezedMagnitude[i-1] = averageMagnitudeOut[i-1];
-                        freezedMagnitude[i] = averageMagnitudeOut[i];
-                        if (i == scopeSize  - 1) newFreezedMagnitude = false;
+                const auto colour = pointColours[start];
+                int end = start + 1;
+                while (end < scopeSize - 1 && pointColours[end] == colour)
+                    ++end;
+
+                tracePath.clear();
+                bool drawing = false;
+                for (int i = start + 1; i <= end; ++i)
+                {
+                    if (!(isCoherent(i - 1) && isCoherent(i)))
+                    {
+                        drawing = false;
+                        continue;
                     }
-                    g.setColour(juce::Colours::aqua);
-                    float x1 = juce::jmap((float)(i - 1), 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                    float y1 = juce::jmap(freezedMagnitude[i - 1], 0.0f, 1.0f, (float)height, 0.0f);
-                    float x2 = juce::jmap((float)i, 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                    float y2 = juce::jmap(freezedMagnitude[i], 0.0f, 1.0f, (float)height, 0.0f);
-                    g.drawLine(x1, y1, x2, y2, 1);
+                    if (!drawing)
+                        tracePath.startNewSubPath((float)(i - 1) * pointWidth, magnitudeY(averageMagnitudeOut[i - 1]));
+                    tracePath.lineTo((float)i * pointWidth, magnitudeY(averageMagnitudeOut[i]));
+                    drawing = true;
                 }
 
-                // Draw the threshold line
-                if (showThreshold)
+                if (!tracePath.isEmpty())
                 {
-                    g.setColour(juce::Colours::purple);
-                    float thresholdY = juce::jmap(clusterThreshold, 0.5f, 1.0f, (float)height / 2, 0.0f);
-                    g.drawHorizontalLine(thresholdY, 0.0f, (float)width);
-                    //Following 2 lines create a dashed line. Unabled because it slows down the GUI
-                    //const float dashLengths[2] = { 4, 5 };
-                    //g.drawDashedLine(juce::Line<float>(0.0f, thresholdY, (float)width, thresholdY), dashLengths, 2);
+                    g.setColour(colour);
+                    g.strokePath(tracePath, juce::PathStrokeType(3.0f));
                 }
+                start = end;
             }
-            // Draw phase -------------------------!!!!
-            float v_offset = getHeight() / 2;
-            for (int i = 1; i < scopeSize; ++i)
+
+            // Draw the response predicted for the fitted EQ
+            if (showPrediction) {
+                tracePath.clear();
+                tracePath.startNewSubPath(0.0f, magnitudeY(predictedMagnitude[0]));
+                for (int i = 1; i < scopeSize; ++i)
+                    tracePath.lineTo((float)i * pointWidth, magnitudeY(predictedMagnitude[i]));
+                g.setColour(juce::Colours::white.withAlpha(0.8f));
+                g.strokePath(tracePath, juce::PathStrokeType(1.5f));
+            }
+
+            // Draw freezed magnitude
+            if (freezed) {
+                tracePath.clear();
+                tracePath.startNewSubPath(0.0f, magnitudeY(freezedMagnitude[0]));
+                for (int i = 1; i < scopeSize; ++i)
+                    tracePath.lineTo((float)i * pointWidth, magnitudeY(freezedMagnitude[i]));
+                g.setColour(juce::Colours::aqua);
+                g.strokePath(tracePath, juce::PathStrokeType(1.0f));
+            }
+
+            // Mark the frequencies the feedback detector has flagged
+            for (int i = 0; i < numFeedbackRings; ++i)
             {
-                g.setColour(juce::Colours::red);
-                float x1 = juce::jmap((float)(i - 1), 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                float y1 = juce::jmap(averagePhaseOut[i - 1], -juce::MathConstants<float>::pi, juce::MathConstants<float>::pi, (float)height, 0.0f) + v_offset;
-                float x2 = juce::jmap((float)i, 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                float y2 = juce::jmap(averagePhaseOut[i], -juce::MathConstants<float>::pi, juce::MathConstants<float>::pi, (float)height, 0.0f) + v_offset;
-
-                // Check for phase wrap
-                const float phaseWrapThreshold = juce::MathConstants<float>::pi * 0.7f; // Add some tolerance
-                if (std::abs(averagePhaseOut[i] - averagePhaseOut[i - 1]) < phaseWrapThreshold)
-                {
-                    g.drawLine(x1, y1, x2, y2, 2);
-                }
+                const auto& ring = feedbackRings[i];
+                const float x = BinMap::frequencyToPoint(ring.frequency, scopeSize) * pointWidth;
 
-                // Draw freezed magnitude
-                if (freezed) {
-                    if (newFreezedPhase) {
-                        freezedPhase[i - 1] = averagePhaseOut[i - 1];
-                        freezedPhase[i] = averagePhaseOut[i];
-                        if (i == scopeSize - 1) newFreezedPhase = false;
-                    }
-                    g.setColour(juce::Colours::indianred);
-                    float x1 = juce::jmap((float)(i - 1), 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                    float y1 = juce::jmap(freezedPhase[i - 1], -juce::MathConstants<float>::pi, juce::MathConstants<float>::pi, (float)height, 0.0f) + v_offset;
-                    float x2 = juce::jmap((float)i, 0.0f, (float)(scopeSize - 1), 0.0f, (float)width);
-                    float y2 = juce::jmap(freezedPhase[i], -juce::MathConstants<float>::pi, juce::MathConstants<float>::pi, (float)height, 0.0f) + v_offset;
-
-                    const float phaseWrapThreshold = juce::MathConstants<float>::pi * 0.7f; // Add some tolerance
-                    if (std::abs(freezedPhase[i] - freezedPhase[i - 1]) < phaseWrapThreshold)
-                    {
-                        g.drawLine(x1, y1, x2, y2, 1);
-                    }
-                }
+                g.setColour(juce::Colours::orangered);
+                g.drawVerticalLine(juce::roundToInt(x), 0.0f, (float)height);
+                g.drawText(juce::String(juce::roundToInt(ring.frequency)) + " Hz",
+                           juce::roundToInt(x) + 3, 45 + 14 * i, 70, 14, juce::Justification::left);
+            }
+
+            // Draw the threshold line
+            if (showThreshold)
+            {
+                g.setColour(juce::Colours::purple);
+                float thresholdY = juce::jmap(clusterThreshold, 0.5f, 1.0f, (float)height / 2, 0.0f);
+                g.drawHorizontalLine(thresholdY, 0.0f, (float)width);
+                //Following 2 lines create a dashed line. Unabled because it slows down the GUI
+                //const float dashLengths[2] = { 4, 5 };
+                //g.drawDashedLine(juce::Line<float>(0.0f, thresholdY, (float)width, thresholdY), dashLengths, 2);
+            }
+
+            // Draw phase, clipped to the phase plot so wrapped segments can
+            // run off its edges
+            float v_offset = getHeight() / 2;
+            juce::Graphics::ScopedSaveState state(g);
+            g.reduceClipRegion(0, (int)v_offset, width, height);
+
+            buildPhasePath(tracePath, averagePhaseOut, true, pointWidth, height, v_offset);
+            g.setColour(juce::Colours::red);
+            g.strokePath(tracePath, juce::PathStrokeType(2.0f));
+
+            // Draw the phase predicted for the fitted EQ
+            if (showPrediction) {
+                buildPhasePath(tracePath, predictedPhase, false, pointWidth, height, v_offset);
+                g.setColour(juce::Colours::white.withAlpha(0.6f));
+                g.strokePath(tracePath, juce::PathStrokeType(1.0f));
+            }
+
+            // Draw freezed phase
+            if (freezed) {
+                buildPhasePath(tracePath, freezedPhase, false, pointWidth, height, v_offset);
+                g.setColour(juce::Colours::indianred);
+                g.strokePath(tracePath, juce::PathStrokeType(1.0f));
             }
         }
         g.setColour(juce::Colours::white);
     }
 
+    // Builds the phase trace as a single path. The averaged phase is a proper
+    // circular mean, so a jump of more than pi between neighbours can only be
+    // a wrap across +-180 deg: the segment is then drawn towards each edge
+    // instead of being dropped. Incoherent points break the path if gated.
+    void buildPhasePath(juce::Path& path, const float* phaseData, bool gated, float pointWidth, int height, float v_offset)
+    {
+        const float pi = juce::MathConstants<float>::pi;
+        auto toY = [height, v_offset, pi](float ph) { return juce::jmap(ph, -pi, pi, (float)height, 0.0f) + v_offset; };
+
+        path.clear();
+        bool drawing = false;
+
+        for (int i = 1; i < scopeSize; ++i)
+        {
+            if (gated && !(isCoherent(i - 1) && isCoherent(i)))
+            {
+                drawing = false;
+                continue;
+            }
+
+            const float x1 = (float)(i - 1) * pointWidth;
+            const float x2 = (float)i * pointWidth;
+            const float delta = phaseData[i] - phaseData[i - 1];
+
+            if (!drawing)
+                path.startNewSubPath(x1, toY(phaseData[i - 1]));
+
+            if (std::abs(delta) > pi)
+            {
+                const float wrap = delta > 0 ? 2.0f * pi : -2.0f * pi;
+                path.lineTo(x2, toY(phaseData[i] - wrap));
+                path.startNewSubPath(x1, toY(phaseData[i - 1] + wrap));
+            }
+
+            path.lineTo(x2, toY(phaseData[i]));
+            drawing = true;
+        }
+    }
+
     void drawFrequencyScale(juce::Graphics& g, int width, int height)
     {
         // Define min and max frequencies
@@ -588,30 +650,35 @@ public:
 
     // Converts a bin in the scope to a frequency
     float bin2freq(int bin) {
-        // Define min and max frequencies
-        const float minFreq = 20.0f;
-        const float maxFreq = 20000.0f;
-
-        // Convert the value to a proportion (0.0 to 1.0)
-        float proportionX = (float)bin / (float)scopeSize;
-
-        // Define the range of the logarithmic scale
-        float logMinFreq = std::log10(minFreq);
-        float logMaxFreq = std::log10(maxFreq);
+        return BinMap::pointToFrequency((float)bin, scopeSize);
+    }
 
-        // Calculate the logarithmic frequency
-        float logFreq = logMinFreq + proportionX * (logMaxFreq - logMinFreq);
-        float freq = std::pow(10, logFreq);
+    static std::array<float, AnalysisEngine::scopeSize> makePointFrequencies()
+    {
+        std::array<float, scopeSize> frequencies;
+        for (int i = 0; i < scopeSize; ++i)
+            frequencies[(size_t)i] = BinMap::pointToFrequency((float)i, scopeSize);
+        return frequencies;
+    }
 
-        return freq;
+    // True if the point's coherence is high enough to trust it, or if the
+    // coherence gate is off
+    bool isCoherent(int index) const
+    {
+        return !coherenceGate || averageCoherenceOut[index] >= minCoherence;
     }
 
-    std::vector<int> findSignificantPeaks(const std::vector<float>& data, float threshold)
+    // Peaks at points with coherence below minCoherence are ignored, so no
+    // filter is spent on reverberant or noisy parts of the response
+    std::vector<int> findSignificantPeaks(const std::vector<float>& data, const std::vector<float>& coherence, float threshold)
     {
         std::vector<int> peaks;
 
         for (int i = 1; i < data.size() - 1; ++i)
         {
+            if (coherenceGate && coherence[i] < minCoherence)
+                continue;
+
             if (std::fabs(data[i]) > threshold &&
                 std::fabs(data[i]) > std::fabs(data[i - 1]) &&
                 std::fabs(data[i]) > std::fabs(data[i + 1]))
@@ -623,145 +690,235 @@ public:
         return peaks;
     }
 
-    std::vector<std::vector<int>> groupPeaksIntoClusters(const std::vector<int>& peaks, int minDistance)
+    // Run of display points [begin, end) holding weight detected peaks
+    struct PeakCluster
+    {
+        int begin = 0;
+        int end = 0;
+        int weight = 0;
+    };
+
+    // Consecutive peaks no further apart than minDistance share a cluster.
+    // peaks must be sorted.
+    std::vector<PeakCluster> groupPeaksIntoClusters(const std::vector<int>& peaks, int minDistance)
     {
-        std::vector<std::vector<int>> clusters;
+        std::vector<PeakCluster> clusters;
         if (peaks.empty()) return clusters;
 
-        std::vector<int> currentCluster = { peaks[0] };
+        clusters.push_back({ peaks[0], peaks[0] + 1, 1 });
 
         for (int i = 1; i < peaks.size(); ++i)
         {
+            auto& current = clusters.back();
+
             if (peaks[i] - peaks[i - 1] <= minDistance)
             {
-                currentCluster.push_back(peaks[i]);
+                current.end = peaks[i] + 1;
+                ++current.weight;
             }
             else
             {
-                clusters.push_back(currentCluster);
-                currentCluster = { peaks[i] };
+                clusters.push_back({ peaks[i], peaks[i] + 1, 1 });
             }
         }
 
-        clusters.push_back(currentCluster);
         return clusters;
     }
 
-    std::vector<std::vector<int>> limitClusters(std::vector<std::vector<int>>& clusters, int maxClusters)
+    // Merges the two closest neighbouring clusters until at most maxClusters
+    // are left. The clusters form a linked list and the gaps between
+    // neighbours sit in a min-heap. Merging only removes a gap (the merged
+    // cluster's gap to its right neighbour is the old right cluster's), so
+    // stale heap entries are skipped when popped. O(n log n) overall.
+    std::vector<PeakCluster> limitClusters(const std::vector<PeakCluster>& clusters, int maxClusters)
     {
-        while (clusters.size() > maxClusters)
+        const int numClusters = (int)clusters.size();
+        if (numClusters <= maxClusters)
+            return clusters;
+
+        struct Gap
         {
-            // Find the two closest clusters
-            int minDistance = std::numeric_limits<int>::max();
-            int mergeIdx1 = 0;
-            int mergeIdx2 = 1;
+            int distance, left, right;
 
-            for (int i = 0; i < clusters.size() - 1; ++i)
+            // Inverted for std::priority_queue, ties go to the leftmost pair
+            bool operator<(const Gap& other) const noexcept
             {
-                int distance = clusters[i + 1].front() - clusters[i].back();
-                if (distance < minDistance)
-                {
-                    minDistance = distance;
-                    mergeIdx1 = i;
-                    mergeIdx2 = i + 1;
-                }
+                return distance != other.distance ? distance > other.distance : left > other.left;
             }
+        };
+
+        std::vector<PeakCluster> merged(clusters);
+        std::vector<int> next((size_t)numClusters);
+        std::vector<bool> alive((size_t)numClusters, true);
+        std::vector<Gap> gaps;
+        gaps.reserve((size_t)numClusters);
 
-            // Merge the two closest clusters
-            clusters[mergeIdx1].insert(clusters[mergeIdx1].end(), clusters[mergeIdx2].begin(), clusters[mergeIdx2].end());
-            clusters.erase(clusters.begin() + mergeIdx2);
+        for (int i = 0; i < numClusters; ++i)
+        {
+            next[(size_t)i] = i + 1;
+            if (i + 1 < numClusters)
+                gaps.push_back({ clusters[(size_t)i + 1].begin - (clusters[(size_t)i].end - 1), i, i + 1 });
         }
 
-        return clusters;
+        std::priority_queue<Gap> heap(std::less<Gap>(), std::move(gaps));
+
+        for (int remaining = numClusters; remaining > maxClusters && !heap.empty();)
+        {
+            const auto gap = heap.top();
+            heap.pop();
+
+            if (!alive[(size_t)gap.left] || next[(size_t)gap.left] != gap.right)
+                continue;
+
+            auto& left = merged[(size_t)gap.left];
+            const auto& right = merged[(size_t)gap.right];
+            left.end = right.end;
+            left.weight += right.weight;
+
+            alive[(size_t)gap.right] = false;
+            next[(size_t)gap.left] = next[(size_t)gap.right];
+            --remaining;
+
+            const int after = next[(size_t)gap.left];
+            if (after < numClusters)
+                heap.push({ merged[(size_t)after].begin - (left.end - 1), gap.left, after });
+        }
+
+        std::vector<PeakCluster> result;
+        result.reserve((size_t)maxClusters);
+        for (int i = 0; i < numClusters; i = next[(size_t)i])
+            result.push_back(merged[(size_t)i]);
+
+        return result;
     }
 
-    void applyFilters(std::vector<std::vector<int>>& clusters, std::vector<float>& data)
+    // Fits one peaking band of the main bus EQ per cluster to the response
+    // captured by Detect, against a flat 0 dB target, and previews the
+    // result. Each cluster seeds its band: centre and width give frequency
+    // and Q, the level at the centre gives the gain. Incoherent points don't
+    // count.
+    void fitFilters(const std::vector<PeakCluster>& clusters, const std::vector<float>& data)
     {
-        for (int i = 0; i < clusters.size(); ++i)
+        float frequencies[scopeSize];
+        float measureddB[scopeSize];
+        float targetdB[scopeSize] {};
+        float weights[scopeSize];
+
+        for (int i = 0; i < scopeSize; ++i)
         {
-            //for (int idx : clusters[i])
-            //{
-                //if (clusters[i].size() > 5)
-                //{
-                    int peaks = clusters[i].size();
-                    int sum = std::accumulate(clusters[i].begin(), clusters[i].end(), 0);
-                    int midIndex = sum / peaks;
-                    float freq = bin2freq(midIndex);
-
-                    DBG("Cluster " << i << ": " << peaks << " peaks, midIndex = " << midIndex << ", freq = " << freq << ", value = " << averageMagnitudeOut[midIndex]);
-
-                    // Set Quality factor
-                    float quality;
-                    if (peaks == 1) {
-                        quality = 4.0f;
-                    }
-                    else if (peaks >= 1 && peaks <= 4) {
-                        quality = 2.2f;
-                    }
-                    else if (peaks >= 5 && peaks <= 14) {
-                        quality = 1.5f;
-                    }
-                    else {
-                        quality = 0.5f;
-                    }
+            frequencies[i] = bin2freq(i);
+            measureddB[i] = (data[i] - 0.5f) * 2.0f * AnalysisEngine::magnitudeRangedB;
+            weights[i] = (!coherenceGate || detectedCoherence[i] >= minCoherence) ? 1.0f : 0.0f;
+        }
 
-                    // Set Gain
-                    float gain;
-                    if (averageMagnitudeOut[midIndex] > 0.71f) {
-						gain = -15.0f;
-					}
-                    else if (averageMagnitudeOut[midIndex] > 0.68f) {
-						gain = -10.0f;
-					}
-                    else if (averageMagnitudeOut[midIndex] > 0.52) {
-                        gain = -5.0f;
-                    }
-                    else {
-                        gain = 0.0f;
-                    }
+        X32Eq::Band seeds[numFittedBands];
+        const int numBands = juce::jmin((int)clusters.size(), numFittedBands);
 
-                    // Construct the OSC message paths with the current cluster index i
-                    std::string freqPath = "/main/st/eq/" + std::to_string(i+2) + "/f";
-                    std::string qualityPath = "/main/st/eq/" + std::to_string(i+2) + "/q";
-                    std::string gainPath = "/main/st/eq/" + std::to_string(i+2) + "/g";
+        for (int i = 0; i < numBands; ++i)
+        {
+            const int first = clusters[i].begin;
+            const int last = clusters[i].end - 1;
+            const int midIndex = (first + last) / 2;
+            const float bandwidth = bin2freq(juce::jmin(last + 1, scopeSize - 1)) - bin2freq(juce::jmax(first - 1, 0));
+
+            seeds[i].frequency = bin2freq(midIndex);
+            seeds[i].q = juce::jlimit(X32Eq::minQ, X32Eq::maxQ, seeds[i].frequency / bandwidth);
+            seeds[i].gaindB = -measureddB[midIndex];
+        }
 
-                    // Convert std::string to juce::OSCAddressPattern
-                    juce::OSCAddressPattern freqPattern(freqPath);
-                    juce::OSCAddressPattern qualityPattern(qualityPath);
-                    juce::OSCAddressPattern gainPattern(gainPath);
+        ParametricEqFitter fitter(frequencies, scopeSize);
+        fittedEq = fitter.fit(measureddB, targetdB, weights, seeds, numBands);
 
-                    // Send OSC messages
-                    OSCEngine->OSCSender.sendCustom(freqPattern, juce::String(freq));
-                    OSCEngine->OSCSender.sendCustom(qualityPattern, juce::String(quality));
-                    OSCEngine->OSCSender.sendCustom(gainPattern, juce::String(gain));
+        DBG("EQ fit: " << fittedEq.numBands << " bands, " << fittedEq.iterations << " iterations, rms error "
+            << fittedEq.rmsErrorBefore << " dB -> " << fittedEq.rmsErrorAfter << " dB");
 
-                //}
-            //}
+        for (int i = 0; i < numFittedBands; ++i)
+        {
+            if (i < fittedEq.numBands)
+                eqPreview.setBand(firstFittedBand - 1 + i, fittedEq.bands[i]);
+            else
+                eqPreview.clearBand(firstFittedBand - 1 + i);
         }
+
+        updatePrediction();
     }
 
-    juce::Colour belongs2cluster(int index) {
-        for (int i = 0; i < clusters.size(); ++i)
+    // Sends the bands found by fitFilters to main bus EQ bands 2 to 6.
+    // Band 1 is never touched.
+    void applyFilters()
+    {
+        ModOSCSender::ScopedBatch batch(OSCEngine->OSCSender);
+
+        for (int i = 0; i < numFittedBands; ++i)
         {
-            for (int idx : clusters[i])
+            const int band = firstFittedBand + i;
+
+            // Bands left over from a previous fit are flattened, and keep
+            // their type
+            if (i >= fittedEq.numBands)
             {
-                if (index == idx)
-                {
-                    switch (i)
-                    {
-                        case 0:
-						    return juce::Colours::aqua;
-                        case 1:
-                            return juce::Colours::hotpink;
-                        case 2:
-                            return juce::Colours::orange;
-                        case 3:
-                            return juce::Colours::green;
-                        case 4:
-                            return juce::Colours::red;
-                    }
-                }
+                OSCEngine->OSCSender.send(X32Osc::mainEqId(band, X32Osc::eqGain), 0.0f);
+                continue;
             }
+
+            const auto& fitted = fittedEq.bands[i];
+            DBG("Band " << band << ": " << fitted.frequency << " Hz, Q " << fitted.q << ", " << fitted.gaindB << " dB");
+
+            OSCEngine->OSCSender.sendInt(X32Osc::mainEqId(band, X32Osc::eqType), (int)fitted.type);
+            OSCEngine->OSCSender.send(X32Osc::mainEqId(band, X32Osc::eqFrequency), fitted.frequency);
+            OSCEngine->OSCSender.send(X32Osc::mainEqId(band, X32Osc::eqQ), fitted.q);
+            OSCEngine->OSCSender.send(X32Osc::mainEqId(band, X32Osc::eqGain), fitted.gaindB);
+        }
+    }
+
+    // Predicted response once the fitted EQ is applied: the response
+    // captured by Detect plus the model's response of the EQ, in display
+    // units
+    void updatePrediction()
+    {
+        const float* eqMagnitude = eqPreview.getMagnitudedB();
+        const float* eqPhase = eqPreview.getPhase();
+        const float pi = juce::MathConstants<float>::pi;
+
+        for (int i = 0; i < scopeSize; ++i)
+        {
+            predictedMagnitude[i] = juce::jlimit(0.0f, 1.0f, data[i] + 0.5f * eqMagnitude[i] / AnalysisEngine::magnitudeRangedB);
+            predictedPhase[i] = std::remainder(detectedPhase[i] + eqPhase[i], 2.0f * pi);
+        }
+
+        showPrediction = true;
+        repaint();
+    }
+
+    // Rebuilds the per-point colour table. Call whenever clusters changes,
+    // so painting never has to search the clusters. Every point in a
+    // cluster's range takes its colour.
+    void updateClusterColours()
+    {
+        std::fill(std::begin(pointColours), std::end(pointColours), juce::Colours::royalblue);
+
+        for (int i = 0; i < (int)clusters.size(); ++i)
+            std::fill(pointColours + clusters[i].begin, pointColours + clusters[i].end, clusterColour(i));
+
+        repaint();
+    }
+
+    static juce::Colour clusterColour(int cluster)
+    {
+        switch (cluster)
+        {
+            case 0:
+                return juce::Colours::aqua;
+            case 1:
+                return juce::Colours::hotpink;
+            case 2:
+                return juce::Colours::orange;
+            case 3:
+                return juce::Colours::green;
+            case 4:
+                return juce::Colours::red;
+            case 5:
+                return juce::Colours::mediumpurple;
         }
         return juce::Colours::royalblue;
     }
@@ -773,28 +930,34 @@ public:
         if (!apply)
         {
             data = std::vector<float>(averageMagnitudeOut, averageMagnitudeOut + scopeSize);
+            detectedPhase = std::vector<float>(averagePhaseOut, averagePhaseOut + scopeSize);
+            detectedCoherence = std::vector<float>(averageCoherenceOut, averageCoherenceOut + scopeSize);
             float threshold = clusterThreshold; // Threshold to detect significant peaks
             int minDistance = 0; // Minimum distance between peaks to consider them in the same cluster
             //int maxClusters = 5; // Maximum number of clusters
 
             // Step 1: Identify significant peaks
-            peaks = findSignificantPeaks(data, threshold);
+            peaks = findSignificantPeaks(data, detectedCoherence, threshold);
 
             // Step 2: Group peaks into clusters
             clusters = groupPeaksIntoClusters(peaks, minDistance);
 
             // Step 3: Limit the number of clusters
             clusters = limitClusters(clusters, maxClusters);
+            updateClusterColours();
+
+            // Step 4: Fit the EQ and preview the corrected response
+            fitFilters(clusters, data);
 
-            // Step 4: Set flag to true
+            // Step 5: Set flag to true
             magnitudeDetected = true;
 
             return;
         }
         if (magnitudeDetected)
 		{
-			// Step 5: Apply filters to the data within each cluster
-            applyFilters(clusters, data);
+			// Step 6: Send the fitted filters to the console
+            applyFilters();
             DBG("Filters applied!");
             return;
 		}
@@ -803,11 +966,7 @@ public:
 
     enum
     {
-        fftOrder = 13,
-        fftSize = 1 << fftOrder,
-        scopeSize = 201,
-        averageNumber = 20,
-        averageFifoSize = scopeSize * averageNumber
+        scopeSize = AnalysisEngine::scopeSize
     };
 
     bool freezed = false;
@@ -815,48 +974,44 @@ public:
     bool newFreezedPhase = false;
 
 private:
-    juce::dsp::FFT forwardFFT;
-    juce::dsp::FFT forwardFFT2;
-    juce::dsp::WindowingFunction<float> window;
-
-    float fifo[fftSize];
-    float fifo2[fftSize];
-    //float fftData[2 * fftSize];
-    //float fftData2[2 * fftSize];
-    std::complex<float> fftInput[fftSize]; // -------!
-    std::complex<float> fftInput2[fftSize];// -------!
-    std::complex<float> fftData[fftSize]; // -------!
-    std::complex<float> fftData2[fftSize];// -------!
-    int fifoIndex = 0;
-    std::array<float, fftSize / 2> phaseDifference;
-
-    bool nextFFTBlockReady = false;
+    static constexpr int referenceBus = 12;           // Feeds OUT2, the reference input
+    static constexpr float signalPresencedB = -60.0f; // On the console meter
+    static constexpr int firstFittedBand = 2;         // Band 1 is left to the engineer (low cut, shelf)
+    static constexpr int numFittedBands = X32Eq::numMainBands - firstFittedBand + 1;
+
+    AnalysisEngine engine;
+
     float scopeData[scopeSize];
-    float rtaMeasurement[scopeSize];
-    float rtaReference[scopeSize];
-    float magnitude[scopeSize];
-    float phase[scopeSize]; // -----------------!
-    int fifoAverageIndex = 0;
-    juce::Array<float> averageMagnitudeFifo;
-    juce::Array<float> averagePhaseFifo;
     float averageMagnitudeOut[scopeSize];
     float averagePhaseOut[scopeSize];
+    float averageCoherenceOut[scopeSize] {};
+    FeedbackDetector::Ring feedbackRings[FeedbackDetector::maxRings];
+    int numFeedbackRings = 0;
     float freezedMagnitude[scopeSize];
     float freezedPhase[scopeSize];
     juce::Array<float> avgMagnitude;
     juce::Array<float> avgMagnitudeSorted;
     int maxIdx = -1;
     int minIdx = -1;
-    OSCSetup* OSCEngine = new OSCSetup();
+    juce::SharedResourcePointer<OSCSetup> OSCEngine; // Shared with MainComponent
     
     float clusterThreshold = 0.5f;
     bool magnitudeDetected = false;
     int maxClusters = 5;
     std::vector<float> data;
+    std::vector<float> detectedCoherence;
+    std::vector<float> detectedPhase;
+    ParametricEqFitter::Result fittedEq;
+    X32Eq::ResponseModel eqPreview { makePointFrequencies().data(), scopeSize };
+    float predictedMagnitude[scopeSize];
+    float predictedPhase[scopeSize];
+    bool showPrediction = false;
     std::vector<int> peaks;
-    std::vector<std::vector<int>> clusters;
+    std::vector<PeakCluster> clusters;
 
     bool showThreshold = false;
+    bool coherenceGate = true;
+    float minCoherence = 0.5f; // Points below this are blanked and not detected
 
     // Buttons and labels
     juce::TextButton detectButton;
@@ -870,8 +1025,23 @@ private:
     juce::Slider thresholdSlider;
     juce::Label  thresholdLabel;
     juce::ToggleButton showThresholdButton;
+    juce::ToggleButton coherenceGateButton;
+    juce::ComboBox overlapBox;
+    juce::ComboBox smoothingBox;
+    juce::ComboBox averagingBox;
+    juce::Slider averageDepthSlider;
+    static constexpr int smoothingFractions[] = { 0, 1, 3, 6, 12, 24, 48 };
 
     int mode = 1;
 
+    juce::Image gridImage;
+    juce::Path tracePath; // Reused so its storage survives between paints
+    juce::Colour pointColours[scopeSize];
+    float gridImageScale = 1.0f;
+    juce::RectangleList<int> traceArea;
+    bool paused = false;
+
+    juce::VBlankAttachment vBlankAttachment { this, [this] { vBlankCallback(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyserComponent)
 };
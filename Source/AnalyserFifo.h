@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    AnalyserFifo.h
+    Created: 18 Oct 2026 10:05:12am
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Wait-free single-producer/single-consumer ring buffer that carries the
+// measurement and reference channels from the audio callback to the analyser.
+// The audio thread only copies whole blocks in, the analyser drains it at its
+// own pace, so nothing is lost while a frame is being processed.
+class AnalyserFifo
+{
+public:
+    AnalyserFifo(int frameSize, int numFrames)
+        : fifo(frameSize * numFrames),
+        buffer(2, frameSize * numFrames)
+    {
+        buffer.clear();
+    }
+
+    // Audio thread only. Returns the number of samples actually written, which
+    // is less than numSamples only if the consumer is a whole buffer behind.
+    // The wrap is handled with at most two vector copies per channel.
+    int push(const float* measurement, const float* reference, int numSamples) noexcept
+    {
+        const auto scope = fifo.write(numSamples);
+
+        if (scope.blockSize1 > 0)
+        {
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(0, scope.startIndex1), measurement, scope.blockSize1);
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(1, scope.startIndex1), reference, scope.blockSize1);
+        }
+
+        if (scope.blockSize2 > 0)
+        {
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(0, scope.startIndex2), measurement + scope.blockSize1, scope.blockSize2);
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(1, scope.startIndex2), reference + scope.blockSize1, scope.blockSize2);
+        }
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    // Analyser side only. Copies up to numSamples into the destinations and
+    // returns how many were read.
+    int pull(float* measurement, float* reference, int numSamples) noexcept
+    {
+        const auto scope = fifo.read(numSamples);
+
+        if (scope.blockSize1 > 0)
+        {
+            juce::FloatVectorOperations::copy(measurement, buffer.getReadPointer(0, scope.startIndex1), scope.blockSize1);
+            juce::FloatVectorOperations::copy(reference, buffer.getReadPointer(1, scope.startIndex1), scope.blockSize1);
+        }
+
+        if (scope.blockSize2 > 0)
+        {
+            juce::FloatVectorOperations::copy(measurement + scope.blockSize1, buffer.getReadPointer(0, scope.startIndex2), scope.blockSize2);
+            juce::FloatVectorOperations::copy(reference + scope.blockSize1, buffer.getReadPointer(1, scope.startIndex2), scope.blockSize2);
+        }
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+    int getFreeSpace() const noexcept { return fifo.getFreeSpace(); }
+
+    // Only safe while the audio device is stopped
+    void reset() noexcept { fifo.reset(); }
+
+private:
+    juce::AbstractFifo fifo;
+    juce::AudioBuffer<float> buffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyserFifo)
+};
@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    AnalysisEngine.h
+    Created: 18 Oct 2026 12:48:51pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalyserFifo.h"
+#include "TripleBuffer.h"
+#include "BinMap.h"
+#include "TransferFunction.h"
+#include "FeedbackDetector.h"
+
+//==============================================================================
+// Background thread that owns the whole dual channel FFT pipeline: it drains
+// the audio FIFO, windows and transforms every frame, maps it to the display
+// points, averages, and publishes the result to the GUI through a triple
+// buffer. Analysis throughput no longer depends on how busy the message
+// thread is.
+class AnalysisEngine : private juce::Thread
+{
+public:
+    enum
+    {
+        fftOrder = 13,
+        fftSize = 1 << fftOrder,
+        scopeSize = 201,
+        averageNumber = 20, // Default averaging depth, in frames
+        fifoFrames = 4, // Audio FIFO capacity, in FFT frames
+        defaultSampleRate = 48000 // Until the device reports its own
+    };
+
+    // Magnitude display range: 0..1 maps to -20..+20 dB
+    static constexpr float magnitudeRangedB = 20.0f;
+
+    // One finished, averaged spectrum as seen by the GUI
+    struct Frame
+    {
+        float magnitude[scopeSize];
+        float phase[scopeSize];
+        float coherence[scopeSize];
+        FeedbackDetector::Ring feedback[FeedbackDetector::maxRings];
+        int numFeedback = 0;
+    };
+
+    AnalysisEngine()
+        : juce::Thread("Analysis Engine"),
+        forwardFFT(fftOrder),
+        window(fftSize, juce::dsp::WindowingFunction<float>::hann),
+        audioFifo(fftSize, fifoFrames),
+        estimator(scopeSize, averageNumber)
+    {
+        binMap.build(defaultSampleRate, fftSize, scopeSize);
+        feedbackDetector.prepare(defaultSampleRate, fftSize);
+
+        for (auto* prefix : { &prefixPower, &prefixPower2, &prefixCrossRe, &prefixCrossIm })
+            prefix->resize(fftSize / 2 + 2, 0.0);
+
+        startThread();
+    }
+
+    ~AnalysisEngine() override
+    {
+        stopThread(1000);
+    }
+
+    // Audio thread: copies one device block of both channels into the FIFO
+    void pushBlock(const float* meas, const float* ref, int numSamples) noexcept
+    {
+        audioFifo.push(meas, ref, numSamples);
+    }
+
+    // Called from prepareToPlay with the real device sample rate. The bin map
+    // is rebuilt on the analysis thread before the next frame.
+    void prepare(double sampleRate) noexcept
+    {
+        if (sampleRate > 0.0)
+            pendingSampleRate.store(sampleRate);
+    }
+
+    // Any thread: N for 1/N octave smoothing, 0 for none. The bin map is
+    // rebuilt on the analysis thread before the next frame.
+    void setSmoothing(int octaveFraction) noexcept
+    {
+        pendingOctaveFraction.store(juce::jmax(0, octaveFraction));
+    }
+
+    // Any thread: how the transfer function is averaged over frames
+    void setAveraging(TransferFunctionEstimator::Averaging mode, int depth) noexcept
+    {
+        estimator.setAveraging(mode, depth);
+    }
+
+    // Any thread: fraction of each frame shared with the previous one. The
+    // engine picks the new hop size up at the next frame boundary.
+    void setOverlap(float overlap) noexcept
+    {
+        hopSize.store(juce::jlimit(1, (int)fftSize, juce::roundToInt((float)fftSize * (1.0f - overlap))));
+    }
+
+    // Any thread: while paused the engine keeps draining the audio FIFO so it
+    // never overflows, but throws the samples away instead of analysing them
+    void setPaused(bool shouldBePaused) noexcept
+    {
+        paused.store(shouldBePaused);
+    }
+
+    // Any thread: while there is no signal to measure, frames are still
+    // checked for feedback but left out of the averages, so the estimate
+    // keeps the last good measurement instead of averaging in the noise
+    void setSignalPresent(bool isPresent) noexcept
+    {
+        signalPresent.store(isPresent);
+    }
+
+    // GUI thread: returns true if a new frame has been published since the
+    // last call. The frame itself stays valid until the next call.
+    bool updateFrame() noexcept { return frames.update(); }
+    const Frame& getFrame() const noexcept { return frames.getReadBuffer(); }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            if (!processAvailableFrames())
+                wait(paused.load() ? 50 : 5);
+        }
+    }
+
+    // Drains the FIFO and processes every complete frame. fifo/fifo2 hold a
+    // sliding window of the last fftSize samples: after each frame only the
+    // oldest hopSize samples are dropped, so consecutive frames overlap.
+    // Returns false if there was nothing to do.
+    bool processAvailableFrames()
+    {
+        if (paused.load())
+        {
+            while (audioFifo.getNumReady() > 0)
+                audioFifo.pull(fifo, fifo2, fftSize);
+
+            // The audio skipped here would read as a jump in every track's
+            // level, so the detector starts afresh on resume
+            fifoIndex = 0;
+            lastHop = fftSize;
+            feedbackDetector.reset();
+            return false;
+        }
+
+        bool newFrame = false;
+
+        while (audioFifo.getNumReady() > 0 && !threadShouldExit())
+        {
+            fifoIndex += audioFifo.pull(fifo + fifoIndex, fifo2 + fifoIndex, fftSize - fifoIndex);
+
+            if (fifoIndex == fftSize)
+            {
+                juce::FloatVectorOperations::copy(fftData, fifo, fftSize);
+                juce::FloatVectorOperations::copy(fftData2, fifo2, fftSize);
+                processFrame();
+                newFrame = true;
+
+                const int hop = hopSize.load();
+                const int kept = fftSize - hop;
+                memmove(fifo, fifo + hop, (size_t)kept * sizeof(float));
+                memmove(fifo2, fifo2 + hop, (size_t)kept * sizeof(float));
+                fifoIndex = kept;
+                lastHop = hop;
+            }
+        }
+
+        return newFrame;
+    }
+
+    void processFrame()
+    {
+        const double sampleRate = pendingSampleRate.load();
+        const int octaveFraction = pendingOctaveFraction.load();
+        if (sampleRate != binMap.getSampleRate() || octaveFraction != binMap.getOctaveFraction())
+            binMap.build(sampleRate, fftSize, scopeSize, octaveFraction);
+        if (sampleRate != feedbackDetector.getSampleRate())
+            feedbackDetector.prepare(sampleRate, fftSize);
+
+        // First apply a windowing function to our data
+        window.multiplyWithWindowingTable(fftData, fftSize);
+        window.multiplyWithWindowingTable(fftData2, fftSize);
+
+        // Then render our FFT data. The input is real, so a real-only transform
+        // gives the non-negative bins (0..fftSize/2) as interleaved complex
+        // values at half the cost of a complex FFT.
+        forwardFFT.performRealOnlyForwardTransform(fftData, true);
+        forwardFFT.performRealOnlyForwardTransform(fftData2, true);
+
+        auto* spectrum = reinterpret_cast<const std::complex<float>*>(fftData);
+        auto* spectrum2 = reinterpret_cast<const std::complex<float>*>(fftData2);
+
+        // Prefix sums of the power and cross spectra over all bins, so that
+        // any band average below costs the same whatever its width. The cross
+        // spectrum is Gxy = conj(X) * Y with X the reference, Y the measurement.
+        for (int k = 0; k <= fftSize / 2; ++k)
+        {
+            const auto cross = std::conj(spectrum2[k]) * spectrum[k];
+            measPower[k] = std::norm(spectrum[k]);
+            prefixPower[k + 1] = prefixPower[k] + measPower[k];
+            prefixPower2[k + 1] = prefixPower2[k] + std::norm(spectrum2[k]);
+            prefixCrossRe[k + 1] = prefixCrossRe[k] + cross.real();
+            prefixCrossIm[k + 1] = prefixCrossIm[k] + cross.imag();
+        }
+
+        // Average the bins behind each display point, as given by the bin map.
+        // Channel 1 is the measurement (y), channel 2 the reference (x). The
+        // cross spectrum is averaged as a complex value, which only holds if
+        // the two channels are delay-aligned (see TransferFunctionEstimator).
+        for (int i = 0; i < scopeSize; ++i)
+        {
+            const auto& range = binMap[i];
+            gyy[i] = (float)(prefixPower[range.end] - prefixPower[range.start]) * range.weight;
+            gxx[i] = (float)(prefixPower2[range.end] - prefixPower2[range.start]) * range.weight;
+            gxyRe[i] = (float)(prefixCrossRe[range.end] - prefixCrossRe[range.start]) * range.weight;
+            gxyIm[i] = (float)(prefixCrossIm[range.end] - prefixCrossIm[range.start]) * range.weight;
+        }
+
+        // Look for ringing in the raw measurement spectrum, at full resolution
+        // and before any averaging slows it down
+        feedbackDetector.process(measPower, fftSize / 2 + 1, (float)(lastHop / sampleRate));
+
+        // Average the spectra, derive magnitude and phase, and hand the
+        // result to the GUI. Without a signal the averages stand still, but
+        // the last estimate is published anyway so the rings stay current.
+        const bool gated = !signalPresent.load();
+
+        if (gated || estimator.addFrame(gxx, gyy, gxyRe, gxyIm))
+        {
+            auto& out = frames.getWriteBuffer();
+            estimator.getMagnitude(out.magnitude, magnitudeRangedB);
+            estimator.getPhase(out.phase);
+            estimator.getCoherence(out.coherence);
+            out.numFeedback = feedbackDetector.getRings(out.feedback);
+            frames.publish();
+        }
+    }
+
+    juce::dsp::FFT forwardFFT;
+    juce::dsp::WindowingFunction<float> window;
+
+    float fifo[fftSize];
+    float fifo2[fftSize];
+    float fftData[2 * fftSize];
+    float fftData2[2 * fftSize];
+    int fifoIndex = 0;
+    int lastHop = fftSize; // Samples between the last two frames
+    std::atomic<int> hopSize { fftSize / 4 };
+    std::atomic<double> pendingSampleRate { (double)defaultSampleRate };
+    std::atomic<int> pendingOctaveFraction { 0 };
+    std::atomic<bool> paused { false };
+    std::atomic<bool> signalPresent { true };
+    BinMap binMap;
+    std::vector<double> prefixPower, prefixPower2, prefixCrossRe, prefixCrossIm;
+    AnalyserFifo audioFifo;
+
+    float gxx[scopeSize];
+    float gyy[scopeSize];
+    float gxyRe[scopeSize];
+    float gxyIm[scopeSize];
+    TransferFunctionEstimator estimator;
+    float measPower[fftSize / 2 + 1];
+    FeedbackDetector feedbackDetector;
+
+    TripleBuffer<Frame> frames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisEngine)
+};
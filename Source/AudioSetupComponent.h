@@ -59,8 +59,6 @@ public:
 
         setAudioChannels(2, 2);
         deviceManager.addChangeListener(this);
-
-        startTimer(50);
     }
 
     ~AudioSetupComponent() override
@@ -69,7 +67,11 @@ public:
         shutdownAudio();
     }
 
-    void prepareToPlay(int, double) override {}
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override
+    {
+        // Called again whenever the device or its settings change
+        analyser.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    }
 
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
     {
@@ -86,8 +88,7 @@ public:
             auto* channelData1 = bufferToFill.buffer->getReadPointer(0, bufferToFill.startSample);
             auto* channelData2 = bufferToFill.buffer->getReadPointer(1, bufferToFill.startSample);
 
-            for (auto i = 0; i < bufferToFill.numSamples; ++i)
-                analyser.pushNextSampleIntoFifo(channelData1[i],channelData2[i]);
+            analyser.pushBlock(channelData1, channelData2, bufferToFill.numSamples);
         }
 
         bufferToFill.clearActiveBufferRegion();
@@ -120,6 +121,12 @@ public:
 
         analyser.setBounds(getWidth() / 16, getHeight() / 8, 5 * getWidth() / 8, 6 * getHeight() / 8);
 
+        updateCpuTimer();
+    }
+
+    void visibilityChanged() override
+    {
+        updateCpuTimer();
     }
 
     AnalyserComponent analyser;
@@ -141,10 +148,24 @@ private:
         return bits.joinIntoString(", ");
     }
 
+    // The CPU readout only polls while its label is laid out and on screen
+    void updateCpuTimer()
+    {
+        if (cpuUsageText.isShowing() && !cpuUsageText.getBounds().isEmpty())
+        {
+            if (!isTimerRunning())
+                startTimer(500);
+        }
+        else
+        {
+            stopTimer();
+        }
+    }
+
     void timerCallback() override
     {
         auto cpu = deviceManager.getCpuUsage() * 100;
-        cpuUsageText.setText(juce::String(cpu, 6) + " %", juce::dontSendNotification);
+        cpuUsageText.setText(juce::String(cpu, 1) + " %", juce::dontSendNotification);
     }
 
     void dumpDeviceInfo()
@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Created: 18 Oct 2026 11:42:30am
+    Author:  josep
+
+    Micro-benchmarks for the realtime paths. Run the app with --benchmark,
+    results are written to the log and the app quits.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalyserFifo.h"
+#include "AnalysisEngine.h"
+#include "FeedbackDetector.h"
+#include "ParametricEqFitter.h"
+
+namespace Benchmarks
+{
+    // Average time spent in AnalyserFifo::push per device callback, which is
+    // everything AnalyserComponent::pushBlock does on the audio thread.
+    inline void callbackCost()
+    {
+        const int blockSizes[] = { 32, 64, 512 };
+        const int numCallbacks = 20000;
+
+        AnalyserFifo fifo(AnalysisEngine::fftSize, AnalysisEngine::fifoFrames);
+        juce::AudioBuffer<float> device(2, 512);
+        juce::AudioBuffer<float> drain(2, 512);
+        juce::Random random;
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < device.getNumSamples(); ++i)
+                device.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+        for (auto blockSize : blockSizes)
+        {
+            juce::int64 ticks = 0;
+
+            for (int n = 0; n < numCallbacks; ++n)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                fifo.push(device.getReadPointer(0), device.getReadPointer(1), blockSize);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+
+                // Consumer keeps up, as the analyser does
+                fifo.pull(drain.getWritePointer(0), drain.getWritePointer(1), blockSize);
+            }
+
+            const auto nsPerCallback = juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / numCallbacks;
+            juce::Logger::writeToLog("pushBlock, " + juce::String(blockSize) + " samples: "
+                                     + juce::String(nsPerCallback, 1) + " ns/callback, "
+                                     + juce::String(nsPerCallback / blockSize, 2) + " ns/sample");
+        }
+    }
+
+    // Compares the real-only transform used by AnalysisEngine against the
+    // complex transform on zero-imaginary data it replaced, end to end: both
+    // paths take the same two-channel frames through the engine's bin map
+    // and the H1 estimator, and the resulting magnitude, phase and coherence
+    // must agree within a tolerance. Also reports the time per transform.
+    inline void realFFTParity()
+    {
+        const double sampleRate = 48000.0;
+        const int fftSize = AnalysisEngine::fftSize;
+        const int numBins = fftSize / 2 + 1;
+        const int numPoints = AnalysisEngine::scopeSize;
+        const int hop = fftSize / 2;
+        const int numFrames = 64;
+        const float magnitudeTolerancedB = 0.01f;
+        const float phaseTolerance = 1.0e-3f;
+        const float coherenceTolerance = 1.0e-3f;
+
+        juce::dsp::FFT fft(AnalysisEngine::fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann);
+        juce::Random random;
+        BinMap binMap;
+        binMap.build(sampleRate, fftSize, numPoints);
+
+        // Reference x is white noise. The measurement y is x through a
+        // short comb with a one sample delay, plus some uncorrelated noise,
+        // so magnitude, phase and coherence all vary across the band.
+        std::vector<float> reference((size_t)(numFrames * hop + fftSize));
+        std::vector<float> measurement(reference.size());
+        for (size_t n = 0; n < reference.size(); ++n)
+        {
+            reference[n] = random.nextFloat() * 2.0f - 1.0f;
+            measurement[n] = 0.6f * (n > 0 ? reference[n - 1] : 0.0f) + 0.3f * (n > 3 ? reference[n - 4] : 0.0f)
+                           + 0.05f * (random.nextFloat() * 2.0f - 1.0f);
+        }
+
+        struct Result
+        {
+            std::vector<float> magnitude, phase, coherence;
+            juce::int64 ticks = 0;
+        };
+
+        // One path of the comparison: frames the signals as the engine does,
+        // transforms them with the given method, band-averages the spectra
+        // and averages them in an estimator
+        const auto analyse = [&](bool realOnly)
+        {
+            Result result;
+            result.magnitude.resize((size_t)numPoints);
+            result.phase.resize((size_t)numPoints);
+            result.coherence.resize((size_t)numPoints);
+
+            TransferFunctionEstimator estimator(numPoints, numFrames);
+            std::vector<float> frameX((size_t)fftSize), frameY((size_t)fftSize);
+            std::vector<float> realX(2 * (size_t)fftSize), realY(2 * (size_t)fftSize);
+            std::vector<std::complex<float>> complexIn((size_t)fftSize), complexX((size_t)fftSize), complexY((size_t)fftSize);
+            std::vector<float> gxx((size_t)numPoints), gyy((size_t)numPoints), gxyRe((size_t)numPoints), gxyIm((size_t)numPoints);
+
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                juce::FloatVectorOperations::copy(frameX.data(), reference.data() + frame * hop, fftSize);
+                juce::FloatVectorOperations::copy(frameY.data(), measurement.data() + frame * hop, fftSize);
+                window.multiplyWithWindowingTable(frameX.data(), (size_t)fftSize);
+                window.multiplyWithWindowingTable(frameY.data(), (size_t)fftSize);
+
+                const std::complex<float>* spectrumX;
+                const std::complex<float>* spectrumY;
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                if (realOnly)
+                {
+                    juce::FloatVectorOperations::copy(realX.data(), frameX.data(), fftSize);
+                    juce::FloatVectorOperations::copy(realY.data(), frameY.data(), fftSize);
+                    fft.performRealOnlyForwardTransform(realX.data(), true);
+                    fft.performRealOnlyForwardTransform(realY.data(), true);
+                    spectrumX = reinterpret_cast<const std::complex<float>*>(realX.data());
+                    spectrumY = reinterpret_cast<const std::complex<float>*>(realY.data());
+                }
+                else
+                {
+                    for (int i = 0; i < fftSize; ++i)
+                        complexIn[(size_t)i] = std::complex<float>(frameX[(size_t)i], 0.0f);
+                    fft.perform(complexIn.data(), complexX.data(), false);
+
+                    for (int i = 0; i < fftSize; ++i)
+                        complexIn[(size_t)i] = std::complex<float>(frameY[(size_t)i], 0.0f);
+                    fft.perform(complexIn.data(), complexY.data(), false);
+
+                    spectrumX = complexX.data();
+                    spectrumY = complexY.data();
+                }
+
+                result.ticks += juce::Time::getHighResolutionTicks() - start;
+
+                // Same band averaging as AnalysisEngine, summed directly
+                for (int i = 0; i < numPoints; ++i)
+                {
+                    const auto& range = binMap[i];
+                    double sxx = 0.0, syy = 0.0, sre = 0.0, sim = 0.0;
+
+                    for (int k = range.start; k < range.end && k < numBins; ++k)
+                    {
+                        const auto cross = std::conj(spectrumX[k]) * spectrumY[k];
+                        sxx += std::norm(spectrumX[k]);
+                        syy += std::norm(spectrumY[k]);
+                        sre += cross.real();
+                        sim += cross.imag();
+                    }
+
+                    gxx[(size_t)i] = (float)sxx * range.weight;
+                    gyy[(size_t)i] = (float)syy * range.weight;
+                    gxyRe[(size_t)i] = (float)sre * range.weight;
+                    gxyIm[(size_t)i] = (float)sim * range.weight;
+                }
+
+                estimator.addFrame(gxx.data(), gyy.data(), gxyRe.data(), gxyIm.data());
+            }
+
+            estimator.getMagnitude(result.magnitude.data(), AnalysisEngine::magnitudeRangedB);
+            estimator.getPhase(result.phase.data());
+            estimator.getCoherence(result.coherence.data());
+            return result;
+        };
+
+        const auto complexPath = analyse(false);
+        const auto realPath = analyse(true);
+
+        float maxMagnitudedB = 0.0f, maxPhase = 0.0f, maxCoherence = 0.0f;
+        const float pi = juce::MathConstants<float>::pi;
+
+        for (size_t i = 0; i < (size_t)numPoints; ++i)
+        {
+            // Display units back to dB
+            const float magnitudedB = 2.0f * AnalysisEngine::magnitudeRangedB * std::abs(realPath.magnitude[i] - complexPath.magnitude[i]);
+            float phase = std::abs(realPath.phase[i] - complexPath.phase[i]);
+            if (phase > pi)
+                phase = 2.0f * pi - phase;
+
+            maxMagnitudedB = juce::jmax(maxMagnitudedB, magnitudedB);
+            maxPhase = juce::jmax(maxPhase, phase);
+            maxCoherence = juce::jmax(maxCoherence, std::abs(realPath.coherence[i] - complexPath.coherence[i]));
+        }
+
+        const bool passed = maxMagnitudedB <= magnitudeTolerancedB && maxPhase <= phaseTolerance && maxCoherence <= coherenceTolerance;
+        const auto usPerTransform = [numFrames](juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6 / (2 * numFrames); };
+
+        juce::Logger::writeToLog("FFT " + juce::String(fftSize) + ", complex: " + juce::String(usPerTransform(complexPath.ticks), 1)
+                                 + " us, real-only: " + juce::String(usPerTransform(realPath.ticks), 1) + " us");
+        juce::Logger::writeToLog(juce::String("FFT parity ") + (passed ? "passed" : "FAILED") + ", max difference: magnitude "
+                                 + juce::String(maxMagnitudedB, 4) + " dB, phase " + juce::String(maxPhase, 5)
+                                 + " rad, coherence " + juce::String(maxCoherence, 5));
+        jassert(passed);
+    }
+
+    // Feeds the feedback detector pink-ish noise with a tone that starts
+    // growing at 20 dB/s, framed as the engine does at 48 kHz with 75%
+    // overlap. Reports the time to flag the tone and the detector's share
+    // of one core.
+    inline void feedbackDetector()
+    {
+        const double sampleRate = 48000.0;
+        const int fftSize = AnalysisEngine::fftSize;
+        const int hop = fftSize / 4;
+        const int numFrames = 200;
+        const int onsetFrame = 50;
+        const float toneFrequency = 2513.0f;
+        const float toneGrowthdBPerSecond = 20.0f;
+
+        juce::dsp::FFT fft(AnalysisEngine::fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann);
+        juce::Random random;
+        FeedbackDetector detector;
+        detector.prepare(sampleRate, fftSize);
+
+        std::vector<float> signal((size_t)(numFrames * hop + fftSize));
+        float lowPassed = 0.0f;
+        for (size_t n = 0; n < signal.size(); ++n)
+        {
+            lowPassed += 0.05f * (random.nextFloat() * 2.0f - 1.0f - lowPassed);
+            const double t = (double)n / sampleRate;
+            const double onset = (double)(onsetFrame * hop + fftSize) / sampleRate;
+            const float gain = t < onset ? 0.0f : 0.01f * std::pow(10.0f, (float)(t - onset) * toneGrowthdBPerSecond / 20.0f);
+            signal[n] = 0.1f * lowPassed + juce::jmin(gain, 1.0f) * std::sin(juce::MathConstants<float>::twoPi * toneFrequency * (float)t);
+        }
+
+        std::vector<float> fftData(2 * (size_t)fftSize);
+        std::vector<float> power((size_t)fftSize / 2 + 1);
+        FeedbackDetector::Ring rings[FeedbackDetector::maxRings];
+        juce::int64 ticks = 0;
+        int flaggedFrame = -1;
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            juce::FloatVectorOperations::copy(fftData.data(), signal.data() + frame * hop, fftSize);
+            window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+            fft.performRealOnlyForwardTransform(fftData.data(), true);
+
+            auto* spectrum = reinterpret_cast<const std::complex<float>*>(fftData.data());
+            for (size_t k = 0; k < power.size(); ++k)
+                power[k] = std::norm(spectrum[k]);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            detector.process(power.data(), (int)power.size(), (float)(hop / sampleRate));
+            const int numRings = detector.getRings(rings);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+
+            for (int i = 0; i < numRings && flaggedFrame < 0; ++i)
+                if (std::abs(rings[i].frequency - toneFrequency) < 10.0f)
+                    flaggedFrame = frame;
+        }
+
+        const double secondsPerFrame = juce::Time::highResolutionTicksToSeconds(ticks) / numFrames;
+        juce::Logger::writeToLog("Feedback detector: " + juce::String(secondsPerFrame * 1.0e6, 1) + " us/frame, "
+                                 + juce::String(100.0 * secondsPerFrame * sampleRate / hop, 3) + "% of one core");
+
+        if (flaggedFrame < 0)
+            juce::Logger::writeToLog("Feedback detector: tone not flagged");
+        else
+            juce::Logger::writeToLog("Feedback detector: tone flagged "
+                                     + juce::String((flaggedFrame - onsetFrame) * hop * 1000.0 / sampleRate, 0) + " ms after onset");
+    }
+
+    // Fits 6 bands to a response made of 6 known peaks plus ripple, from
+    // seeds a third of an octave and a few dB off, on the analyser's points.
+    // Reports the time per fit and the error left.
+    inline void eqFitter()
+    {
+        const int numPoints = AnalysisEngine::scopeSize;
+        const int numRuns = 50;
+        const X32Eq::Band peaks[] = { { X32Eq::BandType::peq, 63.0f, 5.0f, 9.0f },
+                                      { X32Eq::BandType::peq, 180.0f, 3.0f, 6.0f },
+                                      { X32Eq::BandType::peq, 450.0f, 2.0f, 4.0f },
+                                      { X32Eq::BandType::peq, 1600.0f, 8.0f, 10.0f },
+                                      { X32Eq::BandType::peq, 3150.0f, 4.0f, 5.0f },
+                                      { X32Eq::BandType::peq, 8000.0f, 1.5f, 3.0f } };
+
+        std::vector<float> frequencies((size_t)numPoints), measured((size_t)numPoints, 0.0f);
+        std::vector<float> target((size_t)numPoints, 0.0f), weights((size_t)numPoints, 1.0f), band((size_t)numPoints);
+
+        for (int i = 0; i < numPoints; ++i)
+            frequencies[(size_t)i] = BinMap::pointToFrequency((float)i, numPoints);
+
+        X32Eq::MagnitudeKernel kernel(frequencies.data(), numPoints);
+        X32Eq::Band seeds[X32Eq::numMainBands];
+
+        for (int b = 0; b < X32Eq::numMainBands; ++b)
+        {
+            kernel.getMagnitudedB(peaks[b], band.data());
+            juce::FloatVectorOperations::add(measured.data(), band.data(), numPoints);
+            seeds[b] = { X32Eq::BandType::peq, peaks[b].frequency * 1.26f, 2.0f, -peaks[b].gaindB + 3.0f };
+        }
+
+        for (int i = 0; i < numPoints; ++i)
+            measured[(size_t)i] += 0.5f * std::sin(1.7f * (float)i);
+
+        ParametricEqFitter fitter(frequencies.data(), numPoints);
+        ParametricEqFitter::Result result;
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int n = 0; n < numRuns; ++n)
+            result = fitter.fit(measured.data(), target.data(), weights.data(), seeds, X32Eq::numMainBands);
+        const auto ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e3 / numRuns;
+
+        juce::Logger::writeToLog("EQ fit, " + juce::String(result.numBands) + " bands: " + juce::String(ms, 2) + " ms, "
+                                 + juce::String(result.iterations) + " iterations, rms error "
+                                 + juce::String(result.rmsErrorBefore, 2) + " dB -> " + juce::String(result.rmsErrorAfter, 2) + " dB");
+    }
+
+    inline void runAll()
+    {
+        juce::Logger::writeToLog("Running benchmarks...");
+        callbackCost();
+        realFFTParity();
+        feedbackDetector();
+        eqFitter();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    BinMap.h
+    Created: 18 Oct 2026 3:14:40pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Precomputed mapping from FFT bins to the log-frequency display points. Each
+// point owns the range of bins [start, end) that falls inside its slice of
+// the log axis (at least the nearest bin), plus the weight that turns the sum
+// over that range into an average. With fractional-octave smoothing the range
+// is instead the 1/N octave band centred on the point. It only depends on the
+// sample rate, FFT size and smoothing, so it is built once per setting
+// instead of once per frame.
+class BinMap
+{
+public:
+    struct Range
+    {
+        int start = 0;
+        int end = 1;
+        float weight = 1.0f;
+    };
+
+    static constexpr float minFreq = 20.0f;
+    static constexpr float maxFreq = 20000.0f;
+
+    // Centre frequency of a display point, shared with the GUI's frequency axis
+    static float pointToFrequency(float point, int numPoints) noexcept
+    {
+        const float proportionX = point / (float)numPoints;
+        return minFreq * std::pow(maxFreq / minFreq, proportionX);
+    }
+
+    // Inverse of pointToFrequency, fractional
+    static float frequencyToPoint(float frequency, int numPoints) noexcept
+    {
+        return (float)numPoints * std::log(frequency / minFreq) / std::log(maxFreq / minFreq);
+    }
+
+    // Allocates, so call it off the audio thread. octaveFraction is N for 1/N
+    // octave smoothing, or 0 to use each point's own slice of the axis.
+    void build(double newSampleRate, int newFftSize, int numPoints, int newOctaveFraction = 0)
+    {
+        sampleRate = newSampleRate;
+        fftSize = newFftSize;
+        octaveFraction = newOctaveFraction;
+        ranges.resize((size_t)numPoints);
+
+        const int maxBin = fftSize / 2;
+        const double binWidth = sampleRate / (double)fftSize;
+        const double halfStep = octaveFraction > 0
+            ? std::pow(2.0, 0.5 / octaveFraction)
+            : std::sqrt(std::pow((double)maxFreq / (double)minFreq, 1.0 / numPoints));
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const double freq = pointToFrequency((float)i, numPoints);
+            auto& range = ranges[(size_t)i];
+
+            range.start = (int)std::ceil(freq / halfStep / binWidth);
+            range.end = (int)std::floor(freq * halfStep / binWidth) + 1;
+
+            // Below a few hundred Hz a point is narrower than a bin
+            if (range.end <= range.start)
+            {
+                range.start = (int)std::round(freq / binWidth);
+                range.end = range.start + 1;
+            }
+
+            range.start = juce::jlimit(0, maxBin, range.start);
+            range.end = juce::jlimit(range.start + 1, maxBin + 1, range.end);
+            range.weight = 1.0f / (float)(range.end - range.start);
+        }
+    }
+
+    int getNumPoints() const noexcept { return (int)ranges.size(); }
+    double getSampleRate() const noexcept { return sampleRate; }
+    int getOctaveFraction() const noexcept { return octaveFraction; }
+    const Range& operator[](int point) const noexcept { return ranges[(size_t)point]; }
+
+private:
+    double sampleRate = 0.0;
+    int fftSize = 0;
+    int octaveFraction = 0;
+    std::vector<Range> ranges;
+};
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    ConsoleMeters.h
+    Created: 19 Oct 2026 12:21:45am
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "X32Osc.h"
+
+//==============================================================================
+// Latest levels from the console's /meters/1 and /meters/2 streams. The
+// network thread decodes each blob straight from the received bytes into
+// the level arrays, and any thread can read them without locks. Levels are
+// linear, 1.0 is 0 dBFS.
+//
+// A meter blob is a little-endian int32 count followed by that many
+// little-endian floats:
+//   /meters/1: 32 input channels, then gate and dynamics gain reduction
+//   /meters/2: 16 buses, 6 matrices, main L and R, mono, then gain reduction
+class ConsoleMeters
+{
+public:
+    enum
+    {
+        numInputs = 32,
+        numBuses = 16,
+        numMatrices = 6,
+        subscriptionMs = 5000 // Renewal period, the console drops us after 10 s
+    };
+
+    // A view of a received blob. Nothing is copied: values are read from
+    // the bytes as they are needed.
+    class Blob
+    {
+    public:
+        Blob(const void* data, size_t size) noexcept
+        {
+            if (size < 4)
+                return;
+
+            bytes = static_cast<const char*>(data);
+            const auto count = (int)juce::ByteOrder::littleEndianInt(bytes);
+            numValues = juce::jlimit(0, (int)((size - 4) / 4), count);
+        }
+
+        int size() const noexcept { return numValues; }
+
+        float operator[](int index) const noexcept
+        {
+            jassert(juce::isPositiveAndBelow(index, numValues));
+            const auto bits = juce::ByteOrder::littleEndianInt(bytes + 4 + 4 * index);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+    private:
+        const char* bytes = nullptr;
+        int numValues = 0;
+    };
+
+    // Network thread: returns false if the stream or the blob isn't one
+    // we know
+    bool decode(X32Osc::Id stream, const void* data, size_t size) noexcept
+    {
+        const Blob blob(data, size);
+
+        if (stream == X32Osc::meters1 && blob.size() >= numInputs)
+        {
+            copy(blob, 0, inputs, numInputs);
+        }
+        else if (stream == X32Osc::meters2 && blob.size() >= numBuses + numMatrices + 3)
+        {
+            copy(blob, 0, buses, numBuses);
+            copy(blob, numBuses, matrices, numMatrices);
+            copy(blob, numBuses + numMatrices, main, 2);
+            mono.store(blob[numBuses + numMatrices + 2], std::memory_order_relaxed);
+        }
+        else
+        {
+            return false;
+        }
+
+        lastUpdateMs.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+        updateCount.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread. channel, bus and matrix are 1-based, as on the console.
+    float getInput(int channel) const noexcept { return inputs[channel - 1].load(std::memory_order_relaxed); }
+    float getBus(int bus) const noexcept { return buses[bus - 1].load(std::memory_order_relaxed); }
+    float getMatrix(int matrix) const noexcept { return matrices[matrix - 1].load(std::memory_order_relaxed); }
+    float getMain(int side) const noexcept { return main[side].load(std::memory_order_relaxed); } // 0 L, 1 R
+    float getMono() const noexcept { return mono.load(std::memory_order_relaxed); }
+
+    // Goes up with every blob decoded, so readers can skip repeats
+    juce::uint32 getUpdateCount() const noexcept { return updateCount.load(std::memory_order_acquire); }
+
+    // True if a blob arrived in the last maxAgeMs
+    bool isReceiving(juce::uint32 maxAgeMs = 500) const noexcept
+    {
+        return updateCount.load(std::memory_order_acquire) > 0
+            && juce::Time::getMillisecondCounter() - lastUpdateMs.load(std::memory_order_relaxed) <= maxAgeMs;
+    }
+
+private:
+    static void copy(const Blob& blob, int first, std::atomic<float>* dest, int num) noexcept
+    {
+        for (int i = 0; i < num; ++i)
+            dest[i].store(blob[first + i], std::memory_order_relaxed);
+    }
+
+    std::atomic<float> inputs[numInputs] {};
+    std::atomic<float> buses[numBuses] {};
+    std::atomic<float> matrices[numMatrices] {};
+    std::atomic<float> main[2] {};
+    std::atomic<float> mono { 0.0f };
+    std::atomic<juce::uint32> lastUpdateMs { 0 };
+    std::atomic<juce::uint32> updateCount { 0 };
+};
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    ConsoleState.h
+    Created: 18 Oct 2026 11:34:08pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "X32Osc.h"
+
+//==============================================================================
+// Mirror of the console's parameters, as last reported by the X32 (query
+// replies and /xremote pushes). One slot per X32Osc ID, written by the
+// network thread and read from any thread without locks.
+//
+// Each slot is a seqlock: the sequence is odd while a write is in progress
+// and goes up by 2 with every value, so a reader gets a value and the
+// sequence it belongs to, and can tell whether anything changed since it
+// last looked. Sequence 0 means nothing has been received yet.
+class ConsoleState
+{
+public:
+    struct Value
+    {
+        float floatValue = 0.0f; // OSC value, 0..1, for float parameters
+        int intValue = 0;        // For integer parameters
+        juce::uint32 sequence = 0;
+
+        bool isValid() const noexcept { return sequence != 0; }
+    };
+
+    ConsoleState() = default;
+
+    // Network thread only
+    void storeFloat(X32Osc::Id id, float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        store(id, bits);
+    }
+
+    void storeInt(X32Osc::Id id, int value) noexcept
+    {
+        store(id, (juce::uint32)value);
+    }
+
+    // Any thread
+    Value get(X32Osc::Id id) const noexcept
+    {
+        const auto& slot = slots[id];
+        Value value;
+        juce::uint32 bits, before;
+
+        do
+        {
+            before = slot.sequence.load(std::memory_order_acquire);
+            bits = slot.bits.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((before & 1) != 0 || before != slot.sequence.load(std::memory_order_relaxed));
+
+        value.sequence = before;
+        value.intValue = (int)bits;
+        std::memcpy(&value.floatValue, &bits, sizeof(bits));
+        return value;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<juce::uint32> sequence { 0 };
+        std::atomic<juce::uint32> bits { 0 };
+    };
+
+    void store(X32Osc::Id id, juce::uint32 bits) noexcept
+    {
+        auto& slot = slots[id];
+        const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.bits.store(bits, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    Slot slots[X32Osc::numIds];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConsoleState)
+};
@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    FeedbackDetector.h
+    Created: 18 Oct 2026 7:26:13pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Always-on feedback detector, run by the analysis thread on every frame of
+// the measurement channel. It picks the prominent narrow peaks of the power
+// spectrum and follows them from frame to frame. A peak is flagged as ringing
+// when it keeps growing for flagTime, or when it stays at the same frequency
+// for sustainTime after having grown: either through a growth flag earlier
+// on, or by sustainMargindB above where it started (feedback that has
+// stopped growing because something in the chain is limiting it). A steady
+// tone that never grew, such as hum, a test sine or a held note, is never
+// flagged. A flag clears when a growing peak starts to fall before it is
+// sustained, or when the level comes releasedB down from its flagged peak.
+// Everything is fixed-size, nothing allocates.
+class FeedbackDetector
+{
+public:
+    // One flagged frequency, as published to the GUI
+    struct Ring
+    {
+        float frequency = 0.0f;
+        float leveldB = 0.0f;          // Relative to full scale of the FFT
+        float growthdBPerSecond = 0.0f;
+        float duration = 0.0f;         // Seconds since the peak appeared
+    };
+
+    enum
+    {
+        maxRings = 8,   // Flagged frequencies reported per frame
+        maxPeaks = 24,  // Candidate peaks kept per frame
+        maxTracks = 32  // Peaks followed at once
+    };
+
+    static constexpr float prominencedB = 12.0f;          // Above the bins around it
+    static constexpr float maxBelowLoudestdB = 30.0f;     // Quieter peaks are ignored
+    static constexpr float minGrowthdBPerSecond = 8.0f;
+    static constexpr float flagTime = 0.2f;               // Seconds of growth before flagging
+    static constexpr float sustainTime = 1.5f;            // Seconds of a steady tone before flagging
+    static constexpr float maxSustainDriftBins = 0.5f;    // How steady a steady tone is
+    static constexpr float sustainMargindB = 6.0f;        // Rise over the onset level that counts as growth
+    static constexpr float releasedB = 3.0f;              // Drop from the flagged peak that clears a flag
+    static constexpr float matchToleranceBins = 2.0f;
+    static constexpr int maxMissedFrames = 2;
+
+    // Call before the first frame and whenever the sample rate changes.
+    // Forgets every tracked peak.
+    void prepare(double newSampleRate, int newFftSize) noexcept
+    {
+        sampleRate = newSampleRate;
+        binWidth = (float)(newSampleRate / newFftSize);
+        reset();
+    }
+
+    // Forgets every tracked peak, e.g. after a gap in the audio
+    void reset() noexcept
+    {
+        for (auto& track : tracks)
+            track.active = false;
+    }
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    // power holds |Y|^2 for bins 0..numBins-1, frameInterval is the time in
+    // seconds since the previous frame
+    void process(const float* power, int numBins, float frameInterval) noexcept
+    {
+        findPeaks(power, numBins);
+        updateTracks(frameInterval);
+    }
+
+    // Copies the flagged frequencies, loudest first, and returns how many
+    int getRings(Ring* dest) const noexcept
+    {
+        int numRings = 0;
+
+        for (const auto& track : tracks)
+        {
+            if (!track.active || !track.flagged)
+                continue;
+
+            Ring ring { track.bin * binWidth, track.leveldB, track.growth, track.age };
+
+            // Insertion into the short sorted list, dropping the quietest
+            int pos = numRings < maxRings ? numRings++ : maxRings;
+            while (pos > 0 && dest[pos - 1].leveldB < ring.leveldB)
+            {
+                if (pos < maxRings)
+                    dest[pos] = dest[pos - 1];
+                --pos;
+            }
+            if (pos < maxRings)
+                dest[pos] = ring;
+        }
+
+        return numRings;
+    }
+
+private:
+    struct Peak
+    {
+        float bin = 0.0f;     // Interpolated
+        float leveldB = 0.0f;
+        bool matched = false;
+    };
+
+    struct Track
+    {
+        bool active = false;
+        bool flagged = false;
+        float bin = 0.0f;
+        float onsetBin = 0.0f;
+        float drift = 0.0f;   // Largest distance from onsetBin, in bins
+        float leveldB = 0.0f;
+        float onsetLeveldB = 0.0f;
+        float flaggedLeveldB = 0.0f; // Loudest level since the flag went up
+        float growth = 0.0f;  // Smoothed, in dB per second
+        float growingTime = 0.0f; // Seconds growth has stayed above the threshold
+        bool grew = false;    // Growth held for flagTime at some point
+        float age = 0.0f;
+        int missed = 0;
+    };
+
+    enum
+    {
+        guardBins = 8 // Neighbourhood used for the prominence test
+    };
+
+    // Local maxima that stand prominencedB above the mean of the bins 3 to 8
+    // away on either side (outside the Hann main lobe), keeping the loudest
+    // maxPeaks of them
+    void findPeaks(const float* power, int numBins) noexcept
+    {
+        numPeaks = 0;
+
+        const int first = juce::jmax((int)guardBins, (int)std::ceil(20.0f / binWidth));
+        const int last = juce::jmin(numBins - 1 - guardBins, (int)(20000.0f / binWidth));
+        if (last <= first)
+            return;
+
+        const float loudest = juce::FloatVectorOperations::findMaximum(power + first, last - first + 1);
+        const float floor = loudest * std::pow(10.0f, -0.1f * maxBelowLoudestdB);
+        const float prominence = std::pow(10.0f, 0.1f * prominencedB);
+
+        for (int k = first; k <= last; ++k)
+        {
+            const float p = power[k];
+            if (p <= floor || p <= power[k - 1] || p < power[k + 1] || p <= power[k - 2] || p < power[k + 2])
+                continue;
+
+            float neighbourhood = 0.0f;
+            for (int d = 3; d <= guardBins; ++d)
+                neighbourhood += power[k - d] + power[k + d];
+            neighbourhood /= (float)(2 * (guardBins - 2));
+
+            if (p < prominence * neighbourhood)
+                continue;
+
+            // Parabolic interpolation on the log spectrum
+            const float a = toDecibels(power[k - 1]);
+            const float b = toDecibels(p);
+            const float c = toDecibels(power[k + 1]);
+            const float denominator = a - 2.0f * b + c;
+            const float delta = denominator < 0.0f ? juce::jlimit(-0.5f, 0.5f, 0.5f * (a - c) / denominator) : 0.0f;
+
+            Peak peak { (float)k + delta, b - 0.25f * (a - c) * delta };
+
+            if (numPeaks < maxPeaks)
+            {
+                peaks[numPeaks++] = peak;
+                continue;
+            }
+
+            int quietest = 0;
+            for (int i = 1; i < maxPeaks; ++i)
+                if (peaks[i].leveldB < peaks[quietest].leveldB)
+                    quietest = i;
+
+            if (peaks[quietest].leveldB < peak.leveldB)
+                peaks[quietest] = peak;
+        }
+    }
+
+    void updateTracks(float frameInterval) noexcept
+    {
+        // Continue every track with the nearest unclaimed peak
+        for (auto& track : tracks)
+        {
+            if (!track.active)
+                continue;
+
+            Peak* nearest = nullptr;
+            float nearestDistance = matchToleranceBins;
+
+            for (int i = 0; i < numPeaks; ++i)
+            {
+                const float distance = std::abs(peaks[i].bin - track.bin);
+                if (!peaks[i].matched && distance <= nearestDistance)
+                {
+                    nearest = &peaks[i];
+                    nearestDistance = distance;
+                }
+            }
+
+            if (nearest == nullptr)
+            {
+                if (++track.missed > maxMissedFrames)
+                    track.active = false;
+                continue;
+            }
+
+            nearest->matched = true;
+            const float growth = (nearest->leveldB - track.leveldB) / frameInterval;
+            track.growth += 0.5f * (growth - track.growth);
+            track.bin = nearest->bin;
+            track.drift = juce::jmax(track.drift, std::abs(track.bin - track.onsetBin));
+            track.leveldB = nearest->leveldB;
+            track.age += frameInterval;
+            track.missed = 0;
+
+            // A flagged peak that has come down (gain pulled back, cut
+            // applied) is released, and has to grow again to be flagged
+            if (track.flagged && track.leveldB <= track.flaggedLeveldB - releasedB)
+            {
+                track.flagged = track.grew = false;
+                track.growingTime = 0.0f;
+                track.onsetLeveldB = track.leveldB;
+            }
+
+            // Growth has to hold for flagTime without a break. Only a tone
+            // that grew counts as sustained.
+            track.growingTime = track.growth >= minGrowthdBPerSecond ? track.growingTime + frameInterval : 0.0f;
+            track.grew = track.grew || track.growingTime >= flagTime;
+
+            const bool sustained = track.age >= sustainTime && track.drift <= maxSustainDriftBins
+                                && (track.grew || track.leveldB >= track.onsetLeveldB + sustainMargindB);
+
+            if (track.growingTime >= flagTime || sustained)
+            {
+                track.flaggedLeveldB = track.flagged ? juce::jmax(track.flaggedLeveldB, track.leveldB) : track.leveldB;
+                track.flagged = true;
+            }
+            else if (track.growth < 0.0f)
+            {
+                track.flagged = false;
+            }
+        }
+
+        // Start a track for every peak nobody claimed
+        for (int i = 0; i < numPeaks; ++i)
+        {
+            if (peaks[i].matched)
+                continue;
+
+            for (auto& track : tracks)
+            {
+                if (track.active)
+                    continue;
+
+                track = Track();
+                track.active = true;
+                track.bin = track.onsetBin = peaks[i].bin;
+                track.leveldB = track.onsetLeveldB = peaks[i].leveldB;
+                break;
+            }
+        }
+    }
+
+    static float toDecibels(float power) noexcept
+    {
+        return 10.0f * std::log10(power + 1.0e-20f);
+    }
+
+    double sampleRate = 0.0;
+    float binWidth = 1.0f;
+    Peak peaks[maxPeaks];
+    int numPeaks = 0;
+    Track tracks[maxTracks];
+};
@@ -8,6 +8,7 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "Benchmarks.h"
 //#include "AnalyserComponent.h"
 
 //==============================================================================
@@ -26,6 +27,13 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        if (commandLine.contains("--benchmark"))
+        {
+            Benchmarks::runAll();
+            quit();
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
         //mainWindow.reset(new MainWindow("SpectrumAnalyserTutorial", new AnalyserComponent, *this));
     }
@@ -87,6 +95,14 @@ public:
             JUCEApplication::getInstance()->systemRequestedQuit();
         }
 
+        void minimisationStateChanged (bool isNowMinimised) override
+        {
+            DocumentWindow::minimisationStateChanged (isNowMinimised);
+
+            if (auto* content = dynamic_cast<MainComponent*> (getContentComponent()))
+                content->minimisationStateChanged (isNowMinimised);
+        }
+
         /* Note: Be careful if you override any DocumentWindow methods - the base
            class uses a lot of them, so by overriding you might break its functionality.
            It's best to do all your work in your content component instead, but if
@@ -120,6 +120,11 @@ MainComponent::MainComponent()
     addAndMakeVisible(phaseLabel);
     phaseLabel.setText("PHASE", juce::dontSendNotification);
     phaseLabel.setJustificationType(juce::Justification::left);
+
+    addAndMakeVisible(meterBridge);
+
+    // Reading the console state is a few atomic loads, so polling is cheap
+    startTimerHz(10);
 }
 
 MainComponent::~MainComponent()
@@ -163,6 +168,12 @@ void MainComponent::releaseResources()
     // For more details, see the help for AudioProcessor::releaseResources()
 }
 
+void MainComponent::minimisationStateChanged(bool isNowMinimised)
+{
+    // Nobody can see the analyser, so don't spend any CPU on it
+    audioSetup.analyser.setPaused(isNowMinimised);
+}
+
 //void oscMessageReceived(const juce::OSCMessage &message) override
 //{
 //	// This function will be called every time a message is received.
@@ -211,6 +222,7 @@ void MainComponent::resized()
     GEQSlider.setBounds(sliderLeft + getWidth() / 25, sliderLeft, getWidth() / 30, getHeight() / 2);
     delayMeasSlider.setBounds(9 * getWidth() / 16 - getWidth() / 8, 7.3 * getHeight() / 8 + 10, getWidth() / 8, getHeight() / 25);
     delayRefSlider.setBounds(9 * getWidth() / 16 - 2 * getWidth() / 8, 7.3 * getHeight() / 8 + 10, getWidth() / 8, getHeight() / 25);
+    meterBridge.setBounds(14 * getWidth() / 16, 3 * getHeight() / 8, getWidth() / 10, getHeight() / 2.5);
     
 
     // Add labels
@@ -230,7 +242,8 @@ void MainComponent::buttonClicked(juce::Button* button)
 
     if (button == &syncButton) {
 		DBG("Sync button clicked!");
-        OSCEngine->OSCSender.fader("main", "st");
+        OSCEngine->OSCSender.query(X32Osc::mainFader);
+        OSCEngine->OSCSender.query(X32Osc::ch01Fader);
 	}
 
     if (button == &STModeButton)
@@ -240,26 +253,26 @@ void MainComponent::buttonClicked(juce::Button* button)
             DBG("Self-test mode enabled!");
             micSlider.setVisible(false);
             micLabel.setVisible(false);
-            OSCEngine->OSCSender.sendCustom("/outputs/main/01/src", "27"); // OUT1 <- CH2
+            OSCEngine->OSCSender.sendInt(X32Osc::out01Source, 27); // OUT1 <- CH2
         }
         else
         {
             DBG("Self-test mode disabled!");
             micSlider.setVisible(true);
             micLabel.setVisible(true);
-            OSCEngine->OSCSender.sendCustom("/outputs/main/01/src", "26"); // OUT1 <- CH1
+            OSCEngine->OSCSender.sendInt(X32Osc::out01Source, 26); // OUT1 <- CH1
         }
     }
 
     if (button == &delayMeasButton) {
         if (delayMeasOn) {
             delayMeasOn = false;
-            OSCEngine->OSCSender.delayOut("01", false);
+            OSCEngine->OSCSender.delayOut(1, false);
             delayMeasSlider.setVisible(false);
         }
         else {
             delayMeasOn = true;
-            OSCEngine->OSCSender.delayOut("01", true);
+            OSCEngine->OSCSender.delayOut(1, true);
             delayMeasSlider.setVisible(true);
         }
     }
@@ -267,12 +280,12 @@ void MainComponent::buttonClicked(juce::Button* button)
     if (button == &delayRefButton) {
         if (delayRefOn) {
             delayRefOn = false;
-            OSCEngine->OSCSender.delayOut("02", false);
+            OSCEngine->OSCSender.delayOut(2, false);
             delayRefSlider.setVisible(false);
         }
         else {
             delayRefOn = true;
-            OSCEngine->OSCSender.delayOut("02", true);
+            OSCEngine->OSCSender.delayOut(2, true);
             delayRefSlider.setVisible(true);
         }
     }
@@ -297,31 +310,33 @@ void MainComponent::sliderValueChanged (juce::Slider* slider)
 {
     if (slider == &masterFaderSlider) {
         DBG("Slider value: " + juce::String(masterFaderSlider.getValue()));
-        OSCEngine->OSCSender.fader("main", "st", (float)masterFaderSlider.getValue());
+        OSCEngine->OSCSender.fader(X32Osc::mainFader, (float)masterFaderSlider.getValue());
         //OSCEngine->OSCSender.fx(8, 15, (float)masterFaderSlider.getValue());
     }
 
     if (slider == &micSlider) {
         DBG("Mic value: " + juce::String(micSlider.getValue()));
-        OSCEngine->OSCSender.fader("ch", "01", (float)micSlider.getValue());
+        OSCEngine->OSCSender.fader(X32Osc::ch01Fader, (float)micSlider.getValue());
     }
 
     if (slider == &GEQSlider) {
 		DBG("GEQ Slider value: " + juce::String(GEQSlider.getValue()));
+        // Coalesced per band, and the bands that come due together are
+        // bundled by the sender thread
         for (int i = 0; i < 32; i++)
         {
-        OSCEngine->OSCSender.fx(8, i, (float)GEQSlider.getValue());
+        OSCEngine->OSCSender.fx8(i, (float)GEQSlider.getValue());
         }
 	}
 
     if (slider == &delayMeasSlider) {
         DBG("Measurement delay: " + juce::String(delayMeasSlider.getValue()));
-        OSCEngine->OSCSender.delayOut("01", (float)delayMeasSlider.getValue());
+        OSCEngine->OSCSender.delayOut(1, (float)delayMeasSlider.getValue());
     }
 
     if (slider == &delayRefSlider) {
         DBG("Reference delay: " + juce::String(delayRefSlider.getValue()));
-        OSCEngine->OSCSender.delayOut("02", (float)delayRefSlider.getValue());
+        OSCEngine->OSCSender.delayOut(2, (float)delayRefSlider.getValue());
     }
 }
 
@@ -333,3 +348,25 @@ void MainComponent::labelTextChanged(juce::Label* label)
         OSCEngine->changeIPAddress();
 	}
 }
+
+//==============================================================================
+void MainComponent::timerCallback()
+{
+    // Faders moved on the desk, or by another client, show up here
+    followConsole(X32Osc::mainFader, masterFaderSlider, masterFaderSequence);
+    followConsole(X32Osc::ch01Fader, micSlider, micSequence);
+}
+
+void MainComponent::followConsole(X32Osc::Id id, juce::Slider& slider, juce::uint32& lastSequence)
+{
+    const auto value = OSCEngine->consoleState.get(id);
+
+    if (!value.isValid() || value.sequence == lastSequence)
+        return;
+
+    lastSequence = value.sequence;
+
+    // Never fight the user
+    if (!slider.isMouseButtonDown())
+        slider.setValue(value.floatValue, juce::dontSendNotification);
+}
@@ -4,6 +4,7 @@
 #include "OSCSetup.h"
 #include "AnalyserComponent.h"
 #include "AudioSetupComponent.h"
+#include "MeterBridge.h"
 //#include "SlidersSetup.h"
 
 //==============================================================================
@@ -13,10 +14,10 @@
 */
 class MainComponent :
     public juce::AudioAppComponent,
-    public juce::OSCSender,
     public juce::Slider::Listener,
     public juce::Button::Listener,
-    public juce::Label::Listener
+    public juce::Label::Listener,
+    private juce::Timer
     //SpecAnalyzer
     //public juce::Timer
 {
@@ -39,7 +40,16 @@ public:
     void sliderValueChanged(juce::Slider* slider) override;
     void labelTextChanged(juce::Label* label) override;
 
+    //==============================================================================
+    // Called by the main window when it is minimised or restored
+    void minimisationStateChanged(bool isNowMinimised) override;
+
 private:
+    //==============================================================================
+    // Keeps the sliders in step with the console
+    void timerCallback() override;
+    void followConsole(X32Osc::Id id, juce::Slider& slider, juce::uint32& lastSequence);
+
     //==============================================================================
     // Your private member variables go here...
 
@@ -49,9 +59,11 @@ private:
     // Set up the Analyser Component
     /*AnalyserComponent analyser;*/
 
-    // Set up the OSCEngine
-    OSCSetup* OSCEngine = new OSCSetup();
-    //OSCSetup* OSCEngine = OSCSetup::getInstance();
+    // The connection to the console, shared with the analyser
+    juce::SharedResourcePointer<OSCSetup> OSCEngine;
+
+    // Console levels, fed by the meter streams
+    MeterBridge meterBridge { OSCEngine->meters };
 
 
     // Set up Sliders
@@ -79,6 +91,8 @@ private:
     bool freezed = false;
     juce::Label magnitudeLabel;
     juce::Label phaseLabel;
+    juce::uint32 masterFaderSequence = 0;
+    juce::uint32 micSequence = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    MeterBridge.h
+    Created: 19 Oct 2026 12:48:10am
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ConsoleMeters.h"
+
+//==============================================================================
+// Console levels of the signals the measurement depends on: the mic and the
+// generator channels, the reference bus and the main bus. It repaints on the
+// display refresh only when a new meter blob has arrived, so it follows the
+// console's own meter rate.
+class MeterBridge : public juce::Component
+{
+public:
+    static constexpr float mindB = -60.0f;
+    static constexpr float warningdB = -18.0f;
+    static constexpr float clipdB = -6.0f;
+
+    explicit MeterBridge(const ConsoleMeters& metersToShow) : meters(metersToShow)
+    {
+        setOpaque(true);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.fillAll(juce::Colours::black);
+
+        const bool receiving = meters.isReceiving();
+        auto area = getLocalBounds().reduced(4);
+        auto labels = area.removeFromBottom(16);
+        const int stripWidth = area.getWidth() / numStrips;
+
+        for (int i = 0; i < numStrips; ++i)
+        {
+            auto bar = area.removeFromLeft(stripWidth).reduced(3, 0);
+            auto label = labels.removeFromLeft(stripWidth);
+
+            g.setColour(juce::Colours::darkgrey.darker());
+            g.fillRect(bar);
+
+            if (receiving)
+            {
+                const float dB = juce::Decibels::gainToDecibels(getLevel(strips[i]), mindB);
+                const float proportion = juce::jmap(dB, mindB, 0.0f, 0.0f, 1.0f);
+                const auto lit = bar.withTop(bar.getBottom() - juce::roundToInt(proportion * (float)bar.getHeight()));
+
+                g.setColour(dB >= clipdB ? juce::Colours::red
+                          : dB >= warningdB ? juce::Colours::yellow
+                          : juce::Colours::limegreen);
+                g.fillRect(lit);
+            }
+
+            g.setColour(juce::Colours::white);
+            g.setFont(11.0f);
+            g.drawText(strips[i].name, label, juce::Justification::centred);
+        }
+
+        if (!receiving)
+        {
+            g.setColour(juce::Colours::grey);
+            g.drawText("No meters", getLocalBounds(), juce::Justification::centred);
+        }
+    }
+
+private:
+    enum class Source { input, bus, main };
+
+    struct Strip
+    {
+        const char* name;
+        Source source;
+        int index;
+    };
+
+    enum { numStrips = 5 };
+
+    static constexpr Strip strips[numStrips] = {
+        { "Mic", Source::input, 1 },
+        { "Gen", Source::input, 2 },
+        { "Ref", Source::bus, 12 },
+        { "L", Source::main, 0 },
+        { "R", Source::main, 1 }
+    };
+
+    float getLevel(const Strip& strip) const noexcept
+    {
+        switch (strip.source)
+        {
+            case Source::input: return meters.getInput(strip.index);
+            case Source::bus:   return meters.getBus(strip.index);
+            default:            return meters.getMain(strip.index);
+        }
+    }
+
+    void vBlankCallback()
+    {
+        const auto count = meters.getUpdateCount();
+        const bool receiving = meters.isReceiving();
+
+        if (count != lastUpdateCount || receiving != wasReceiving)
+        {
+            lastUpdateCount = count;
+            wasReceiving = receiving;
+            repaint();
+        }
+    }
+
+    const ConsoleMeters& meters;
+    juce::uint32 lastUpdateCount = 0;
+    bool wasReceiving = false;
+    juce::VBlankAttachment vBlankAttachment { this, [this] { vBlankCallback(); } };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterBridge)
+};
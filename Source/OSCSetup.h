@@ -10,189 +10,572 @@
 
 #pragma once
 #include <JuceHeader.h>
-
+#include "X32Osc.h"
+#include "ConsoleState.h"
+#include "ConsoleMeters.h"
+
+//==============================================================================
+// Sender for the X32 commands. Nothing is sent from the calling thread: the
+// messages are queued and a background thread transmits them, so a large
+// recall never stalls the GUI. Messages sent inside a batch (see
+// ScopedBatch) go out together, as OSC bundles or, if the console is set up
+// not to take bundles, as a paced burst of single messages.
+//
+// Continuous controls (faders, delays, GEQ) go through setParameter instead:
+// the last value per parameter wins, and each parameter is sent at most
+// maxRate times per second. The final value of a move is always sent.
+//
+// Addresses are X32Osc IDs, serialised once at startup, and values are sent
+// with the console's own argument types (binary floats and ints, never
+// text). Packets are encoded into a stack buffer and written straight to
+// the socket, so no send allocates.
 class ModOSCSender :
-    public juce::OSCSender
+    private juce::Thread
 {
 public:
-    ModOSCSender() {
+    enum
+    {
+        maxMessagesPerBundle = 16, // Keeps every bundle well inside one datagram
+        burstPacingMs = 1,         // Gap between messages of an unbundled batch
+        defaultMaxRate = 50,       // Per parameter, in Hz
+        maxBatchSize = 128,
+        queueSize = 512,           // Messages waiting for the sender thread
+        maxQueueWaitMs = 200,      // How long a send waits for room in a full queue
+        maxKeepAlives = 4
+    };
+
+    ModOSCSender() : juce::Thread("OSC Sender") {
+        X32Osc::AddressTable::getInstance(); // Built here, not on the first send
+        startThread();
     }
 
-    void fader(juce::String type, juce::String number) {
-        this->send("/"+ type + "/" + juce::String(number) + "/mix/fader");
+    ~ModOSCSender() override {
+        stopThread(1000);
     }
 
-    void fader(juce::String type, juce::String number, float value) {
-        this->send("/" + type + "/" + number + "/mix/fader", value);
-    }
+    // Message thread: everything sent while a ScopedBatch is alive is
+    // collected and queued as one batch when the outermost one goes away
+    class ScopedBatch
+    {
+    public:
+        explicit ScopedBatch(ModOSCSender& senderToUse) : sender(senderToUse)
+        {
+            JUCE_ASSERT_MESSAGE_THREAD
+            ++sender.batchDepth;
+        }
 
-    void delayOut(juce::String out, bool on) {
-        this->send("/outputs/main/" + out + "/delay/on", on);
+        ~ScopedBatch()
+        {
+            if (--sender.batchDepth == 0 && sender.numPending > 0)
+            {
+                sender.enqueue(sender.pending, sender.numPending);
+                sender.numPending = 0;
+            }
+        }
+
+    private:
+        ModOSCSender& sender;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBatch)
+    };
+
+    // Any thread: false sends batches as paced bursts of single messages
+    void setUseBundles(bool shouldUseBundles) {
+        useBundles = shouldUseBundles;
     }
 
-    void delayOut(juce::String out, float time) {
-        time = (time - 0.2) / 500;
-        this->send("/outputs/main/" + out + "/delay/time", time);
-        DBG(time);
+    // Any thread: how often a single parameter may be sent, in Hz
+    void setMaxRate(double ratePerSecond) {
+        minIntervalMs.store(1000.0 / juce::jmax(1.0, ratePerSecond));
     }
 
-    void fx(int number, int parameter, float value) {
-        if (parameter < 10)
+    // Any thread: queues a float parameter, in the physical units of its
+    // X32Osc table entry. If it already has a value waiting it is replaced,
+    // so a fast move only sends what the console can use.
+    void setParameter(X32Osc::Id id, float value) {
+        const float oscValue = X32Osc::toValue(id, value);
         {
-            this->send("/fx/" + juce::String(number) + "/par/0" + juce::String(parameter), value);
+            const juce::ScopedLock sl(queueLock);
+            parameters[id].value = oscValue;
+            parameters[id].pending = true;
         }
-        else {
-            this->send("/fx/" + juce::String(number) + "/par/" + juce::String(parameter), value);
+        notify();
+    }
+
+    // Any thread: where the packets go. The socket must outlive the sender.
+    bool reconnect(juce::DatagramSocket& socketToUse, const juce::String& targetHostName, int targetPortNumber) {
+        const juce::ScopedLock sl(sendLock);
+        socket = &socketToUse;
+        targetHost = targetHostName;
+        targetPort = targetPortNumber;
+        return targetHost.isNotEmpty() && targetPort > 0;
+    }
+
+    // Any thread: sends the message now and then every intervalMs until the
+    // sender goes away, for subscriptions the console lets lapse (/xremote,
+    // /meters)
+    void keepAlive(const X32Osc::Message& message, int intervalMs) {
+        {
+            const juce::ScopedLock sl(queueLock);
+            jassert(numKeepAlives < maxKeepAlives);
+
+            if (numKeepAlives < maxKeepAlives)
+                keepAlives[numKeepAlives++] = { message, (double)intervalMs };
         }
-	}
+        notify();
+    }
+
+    // Message thread, as are send and sendInt. They return false if the
+    // queue stayed full and the message was dropped. Inside a ScopedBatch
+    // that is only known when the batch is queued.
+    //
+    // A message with no arguments asks the console for the current value
+    bool query(X32Osc::Id id) {
+        return post(X32Osc::Message::query(id));
+    }
+
+    // A float parameter, in the physical units of its X32Osc table entry
+    bool send(X32Osc::Id id, float value) {
+        return post(X32Osc::Message::withPhysical(id, value));
+    }
+
+    // An enum, switch or routing index
+    bool sendInt(X32Osc::Id id, int value) {
+        return post(X32Osc::Message::withInteger(id, value));
+    }
+
+    void fader(X32Osc::Id id, float value) {
+        setParameter(id, value);
+    }
+
+    // output is 1 or 2
+    void delayOut(int output, bool on) {
+        sendInt(output == 1 ? X32Osc::out01DelayOn : X32Osc::out02DelayOn, (int)on);
+    }
+
+    // time in ms
+    void delayOut(int output, float time) {
+        setParameter(output == 1 ? X32Osc::out01DelayTime : X32Osc::out02DelayTime, time);
+    }
+
+    void fx8(int parameter, float value) {
+        setParameter(X32Osc::fx8ParId(parameter), value);
+    }
 
     void sendCh1() {
-        if (this->send("/ch/01/mix/fader", (float)0.8250)) {
-            DBG("Ch1 sent!");
-        }
+        send(X32Osc::ch01Fader, (float)0.8250);
+        DBG("Ch1 sent!");
     }
 
     void sendCh1(float level) {
-        if (this->send("/ch/01/mix/fader", level)) {
-            //DBG("Ch1 sent!");
-        }
+        send(X32Osc::ch01Fader, level);
     }
 
     void askCh1() {
-        if (this->send("/ch/01/mix/fader")) {
-			DBG("Ch1 asked!");
-		}
+        query(X32Osc::ch01Fader);
+		DBG("Ch1 asked!");
 	}
 
     void sendInfo() {
-        if (this->send("/info")) {
-            DBG("Info sent!");
-        }
+        query(X32Osc::info);
+        DBG("Info sent!");
     }
 
     void sendStatus() {
-        if (this->send("/status")) {
-            DBG("Status sent!");
+        query(X32Osc::status);
+        DBG("Status sent!");
+    }
+
+    // channel is 1 or 2
+    void resetChEq(int channel){
+        ScopedBatch batch(*this);
+        for (int i = 1; i <= 4; i++)
+            send(X32Osc::channelEqGainId(channel, i), 0.0f);
+    }
+
+    void resetStEq() {
+        ScopedBatch batch(*this);
+        for (int i = 1; i <= 6; i++)
+            send(X32Osc::mainEqId(i, X32Osc::eqGain), 0.0f);
+    }
+
+    void initX32() {
+        ScopedBatch batch(*this);
+        sendInt(X32Osc::mainOn, 1);
+        send(X32Osc::mainFader, X32Osc::faderLevel(-90.0f));
+        resetStEq();
+        sendInt(X32Osc::bus12On, 1);
+        send(X32Osc::oscLevel, X32Osc::faderLevel(-20.0f));
+        sendInt(X32Osc::oscType, 1);
+        sendInt(X32Osc::oscDest, 11);
+        sendInt(X32Osc::statOscOn, 1);
+        send(X32Osc::bus12Fader, 0.7478f); // 0 dB
+        sendInt(X32Osc::out02Source, 15); // Send MixBus 12 to OUT2
+        sendInt(X32Osc::ch02Source, 60);
+        send(X32Osc::ch02Trim, 0.0f);
+        sendInt(X32Osc::ch02On, 1);
+        send(X32Osc::ch02Fader, X32Osc::faderLevel(0.0f));
+        resetChEq(2);
+        resetChEq(1);
+        sendInt(X32Osc::out01Source, 26); // Send Ch 01 to OUT1
+        sendInt(X32Osc::cardRouting, 20);
+    }
+
+private:
+    struct Parameter
+    {
+        float value = 0.0f;
+        double lastSentMs = -1.0e9;
+        bool pending = false;
+    };
+
+    struct KeepAlive
+    {
+        X32Osc::Message message;
+        double intervalMs = 0.0;
+        double lastSentMs = -1.0e9;
+    };
+
+    struct Entry
+    {
+        X32Osc::Message message;
+        bool endsBatch = true;
+    };
+
+    // Adds the message to the open batch, or queues it on its own. A value
+    // sent outright supersedes any setParameter value still waiting for
+    // the same ID, so the last command wins.
+    bool post(const X32Osc::Message& message) {
+        JUCE_ASSERT_MESSAGE_THREAD
+
+        if (message.type != 0)
+        {
+            const juce::ScopedLock sl(queueLock);
+            parameters[message.id].pending = false;
+        }
+
+        if (batchDepth > 0)
+        {
+            if (numPending == maxBatchSize)
+            {
+                enqueue(pending, numPending);
+                numPending = 0;
+            }
+            pending[numPending++] = message;
+            return true;
         }
+
+        return enqueue(&message, 1);
     }
 
-    void sendCustom(const juce::OSCAddressPattern& address, juce::String args) {
-        if (this->send(address, args)) {
-			DBG("Custom command sent!");
-		}
+    // Queues the messages as one batch. If there is no room, the sender
+    // thread is woken and the caller waits up to maxQueueWaitMs for it to
+    // drain the queue. Returns false if the batch had to be dropped.
+    bool enqueue(const X32Osc::Message* messages, int numMessages) {
+        jassert(numMessages <= queueSize);
+
+        for (bool waited = false;; waited = true)
+        {
+            {
+                const juce::ScopedLock sl(queueLock);
+
+                if (queueCount + numMessages <= queueSize)
+                {
+                    for (int i = 0; i < numMessages; ++i)
+                    {
+                        auto& entry = queue[(queueStart + queueCount++) % queueSize];
+                        entry.message = messages[i];
+                        entry.endsBatch = i == numMessages - 1;
+                    }
+                    break;
+                }
+
+                if (waited)
+                {
+                    DBG("OSC queue full, batch dropped");
+                    jassertfalse;
+                    return false;
+                }
+
+                queueDrained.reset();
+            }
+
+            notify();
+            queueDrained.wait(maxQueueWaitMs);
+        }
+
+        notify();
+        return true;
     }
 
-    void resetChEq(std::string ch){
-        for (int i = 1; i <= 4; i++)
+    void run() override {
+        int timeoutMs = -1;
+
+        while (!threadShouldExit())
         {
-            std::string gainPath = "/ch/" + ch + "/eq/" + std::to_string(i) + "/g";
-            juce::OSCAddressPattern gainPattern(gainPath);
-            this->sendCustom(gainPattern, "0");
+            wait(timeoutMs);
+
+            int numOutgoing = 0;
+            int numDue = 0;
+
+            {
+                const juce::ScopedLock sl(queueLock);
+
+                for (; queueCount > 0; --queueCount, queueStart = (queueStart + 1) % queueSize)
+                {
+                    outgoing[numOutgoing] = queue[queueStart].message;
+                    outgoingEndsBatch[numOutgoing++] = queue[queueStart].endsBatch;
+                }
+
+                queueDrained.signal();
+
+                timeoutMs = collectDueParameters(numDue);
+            }
+
+            int batchStart = 0;
+            for (int i = 0; i < numOutgoing; ++i)
+            {
+                if (outgoingEndsBatch[i])
+                {
+                    transmit(outgoing + batchStart, i + 1 - batchStart);
+                    batchStart = i + 1;
+                }
+            }
+
+            // Parameters and renewals that came due together go out as one
+            // batch
+            if (numDue > 0)
+                transmit(due, numDue);
         }
     }
 
-    void resetStEq() {
-        for (int i = 1; i <= 6; i++)
+    // Moves every pending parameter whose interval has elapsed, and every
+    // keep-alive that needs renewing, into due. Returns how long until the
+    // next one is due, or -1 if none is waiting. Called with queueLock held.
+    int collectDueParameters(int& numDue) {
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        const double interval = minIntervalMs.load();
+        double nextDue = -1.0;
+
+        for (int i = 0; i < numKeepAlives; ++i)
+        {
+            auto& keepAlive = keepAlives[i];
+            const double remaining = keepAlive.lastSentMs + keepAlive.intervalMs - now;
+
+            if (remaining <= 0.0)
+            {
+                due[numDue++] = keepAlive.message;
+                keepAlive.lastSentMs = now;
+            }
+            else if (nextDue < 0.0 || remaining < nextDue)
+            {
+                nextDue = remaining;
+            }
+        }
+
+        for (int id = 0; id < X32Osc::numIds; ++id)
         {
-            std::string gainPath = "/main/st/eq/" + std::to_string(i) + "/g";
-            juce::OSCAddressPattern gainPattern(gainPath);
-            this->sendCustom(gainPattern, "0");
+            auto& parameter = parameters[id];
+            if (!parameter.pending)
+                continue;
+
+            const double remaining = parameter.lastSentMs + interval - now;
+            if (remaining <= 0.0)
+            {
+                due[numDue++] = X32Osc::Message::withFloat((X32Osc::Id)id, parameter.value);
+                parameter.lastSentMs = now;
+                parameter.pending = false;
+            }
+            else if (nextDue < 0.0 || remaining < nextDue)
+            {
+                nextDue = remaining;
+            }
         }
+
+        return nextDue < 0.0 ? -1 : juce::jmax(1, (int)std::ceil(nextDue));
     }
 
-    void initX32() {
-        sendCustom("/main/st/mix/on", "1");
-        sendCustom("/main/st/mix/fader", "-90.0");
-        resetStEq();
-        sendCustom("/bus/12/mix/on", "1");
-        sendCustom("/config/osc/level", "0.3750");
-        sendCustom("/config/osc/type", "1");
-        sendCustom("/config/osc/dest", "11");
-        sendCustom("/-stat/osc/on", "1");
-        sendCustom("/bus/12/mix/fader", "0.7478");
-        sendCustom("/outputs/main/02/src", "15"); // Send MixBus 12 to OUT2
-        sendCustom("/ch/02/source", "60");
-        sendCustom("/ch/02/preamp/trim", "0.0");
-        sendCustom("/ch/02/mix/on", "1");
-        sendCustom("/ch/02/mix/fader", "0.0");
-        resetChEq("02");
-        resetChEq("01");
-        sendCustom("/outputs/main/01/src", "26"); // Send Ch 01 to OUT1
-        sendCustom("/config/routing/CARD/1-8", "20");
+    void transmit(const X32Osc::Message* messages, int numMessages) {
+        char packet[X32Osc::maxPacketSize];
+        X32Osc::PacketWriter writer(packet, X32Osc::maxPacketSize);
+
+        if (numMessages == 1 || !useBundles)
+        {
+            for (int i = 0; i < numMessages; ++i)
+            {
+                if (i > 0)
+                    juce::Thread::sleep(burstPacingMs);
+
+                writer.reset();
+                if (writer.writeMessage(messages[i]))
+                    write(writer);
+            }
+            return;
+        }
+
+        int numInChunk = 0;
+        writer.beginBundle();
+
+        for (int i = 0; i < numMessages; ++i)
+        {
+            // Start a new bundle when this one is full, in count or in bytes
+            if (numInChunk == maxMessagesPerBundle || !writer.addToBundle(messages[i]))
+            {
+                if (numInChunk > 0)
+                    write(writer);
+
+                writer.beginBundle();
+                numInChunk = 0;
+
+                if (!writer.addToBundle(messages[i]))
+                    continue;
+            }
+
+            ++numInChunk;
+        }
+
+        if (numInChunk > 0)
+            write(writer);
     }
 
+    void write(const X32Osc::PacketWriter& writer) {
+        const juce::ScopedLock sl(sendLock);
+        if (socket == nullptr || socket->write(targetHost, targetPort, writer.getData(), writer.getSize()) < 0)
+            DBG("OSC send failed");
+    }
+
+    int batchDepth = 0;                            // Message thread only
+    X32Osc::Message pending[maxBatchSize];         // Message thread only
+    int numPending = 0;                            // Message thread only
+    juce::CriticalSection queueLock;
+    Entry queue[queueSize];                        // Ring, guarded by queueLock
+    int queueStart = 0, queueCount = 0;
+    juce::WaitableEvent queueDrained;              // Signalled whenever the sender thread empties the queue
+    Parameter parameters[X32Osc::numIds];          // Indexed by ID, guarded by queueLock
+    X32Osc::Message outgoing[queueSize];           // Sender thread only
+    bool outgoingEndsBatch[queueSize] {};          // Sender thread only
+    KeepAlive keepAlives[maxKeepAlives];           // Guarded by queueLock
+    int numKeepAlives = 0;
+    X32Osc::Message due[X32Osc::numIds + maxKeepAlives]; // Sender thread only
+    std::atomic<double> minIntervalMs { 1000.0 / defaultMaxRate };
+    juce::CriticalSection sendLock;
+    juce::DatagramSocket* socket = nullptr;        // Guarded by sendLock
+    juce::String targetHost;
+    int targetPort = 0;
+    std::atomic<bool> useBundles { true };
 };
 
 
+//==============================================================================
+// Receiver for the console's replies, /xremote pushes and meter streams.
+// Packets are decoded on the network thread (RealtimeCallback): every
+// parameter we know goes straight into the ConsoleState and every meter
+// blob into the ConsoleMeters, so nothing is posted to the message thread.
+// Addresses we don't have an ID for are ignored.
 class ModOSCReceiver :
     public juce::OSCReceiver,
-    public juce::OSCReceiver::Listener<juce::OSCReceiver::MessageLoopCallback>
+    private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>
 {
 public:
-    ModOSCReceiver()
+    ModOSCReceiver(ConsoleState& stateToUpdate, ConsoleMeters& metersToUpdate)
+        : state(stateToUpdate), meters(metersToUpdate)
     {
-        // tell the component to listen for OSC messages matching this address:
-        //addListener(this, "/xremote");
         addListener(this);
-
-        /*if (this->connectToSocket(socket)) {
-            DBG("OSCReceiver Connected!");
-        }*/
     }
 
+private:
     void oscMessageReceived(const juce::OSCMessage& message) override
     {
-        //int size = message.size();
-        for (int i = 0; i < message.size(); i++)
+        X32Osc::Id id;
+        if (message.size() != 1
+            || !X32Osc::AddressTable::getInstance().find(message.getAddressPattern().toString().toRawUTF8(), id))
+            return;
+
+        const auto& argument = message[0];
+
+        switch (X32Osc::getParameterInfo(id).type)
         {
-            if (message[i].isFloat32())
-			{
-				DBG("OSC Received:" << message[i].getFloat32());
-			}
-			else if (message[i].isInt32())
-			{
-				DBG("OSC Received:" << message[i].getInt32());
-			}
-			else if (message[i].isString())
-			{
-				DBG("OSC Received:" << message[i].getString());
-			}
-        }
-        //DBG("OSC Received:" << message.begin()->getString());
-        /*DBG("Message received");
-        if (message.size() == 1 && message[0].isFloat32())
-            DBG("Message received + if");*/
+            case X32Osc::Type::none:
+                break;
+            case X32Osc::Type::integer:
+                if (argument.isInt32())
+                    state.storeInt(id, argument.getInt32());
+                break;
+            case X32Osc::Type::blob:
+                if (argument.isBlob())
+                    meters.decode(id, argument.getBlob().getData(), argument.getBlob().getSize());
+                break;
+            default:
+                if (argument.isFloat32())
+                    state.storeFloat(id, argument.getFloat32());
+                break;
+        }
     }
 
     void oscBundleReceived(const juce::OSCBundle& bundle) override
     {
-        DBG("Bundle received");
+        for (const auto& element : bundle)
+        {
+            if (element.isMessage())
+                oscMessageReceived(element.getMessage());
+            else if (element.isBundle())
+                oscBundleReceived(element.getBundle());
+        }
     }
+
+    ConsoleState& state;
+    ConsoleMeters& meters;
 };
 
 
 
 
+//==============================================================================
+// The one connection to the console, shared by every component through
+// juce::SharedResourcePointer<OSCSetup>: one socket bound to the reply
+// port, one sender thread and one receiver thread, so every reply is
+// decoded once, into one ConsoleState and one ConsoleMeters. It's created
+// by the first component that asks for it and goes away with the last one.
+// After that the handles need no locking: the sender queues under its own
+// short lock, and the state and meters are read lock-free.
 class OSCSetup
 {
-private:
-    /*static OSCSetup* OSCinstance;*/
 public:
+    enum
+    {
+        localPort = 10022,
+        consolePort = 10023
+    };
+
     OSCSetup()
     {
-        // Create a socket that will listen to the given port number
-        socket.bindToPort(10022);
-        socket.setEnablePortReuse(true);
-        if (OSCSender.connectToSocket(socket, "169.254.121.37", 10023)) {
+        // No port reuse: a second copy of the tool must fail to bind rather
+        // than silently take some of the replies
+        if (!socket.bindToPort(localPort)) {
+            DBG("Could not bind OSC port " << (int)localPort);
+        }
+        if (OSCSender.reconnect(socket, IPAddress, consolePort)) {
 			DBG("OSCSender Connected!");
 		}
         if (OSCReceiver.connectToSocket(socket)) {
             DBG("OSCReceiver Connected!");
         }
+
+        // The console stops pushing changes 10 s after the last /xremote,
+        // and meter data 10 s after the last /meters
+        OSCSender.keepAlive(X32Osc::Message::query(X32Osc::xremote), 9000);
+        OSCSender.keepAlive(X32Osc::Message::withAddress(X32Osc::meters, X32Osc::meters1), ConsoleMeters::subscriptionMs);
+        OSCSender.keepAlive(X32Osc::Message::withAddress(X32Osc::meters, X32Osc::meters2), ConsoleMeters::subscriptionMs);
+    }
+
+    ~OSCSetup()
+    {
+        // Stop decoding before the state and meters go away
+        OSCReceiver.disconnect();
     }
 
     void changeIPAddress() {
-        if (OSCSender.connectToSocket(socket, IPAddress, 10023)) {
+        if (OSCSender.reconnect(socket, IPAddress, consolePort)) {
             DBG("IP Address changed to: " + IPAddress);
         }
         else {
@@ -200,18 +583,12 @@ public:
         }
 	}
 
-    /*static OSCSetup* getInstance()
-	    {
-		    if (OSCinstance == nullptr)
-		    {
-			    OSCinstance = new OSCSetup();
-		    }
-		    return OSCinstance;
-	    }*/
-
+    juce::String IPAddress = "169.254.121.37";
     juce::DatagramSocket socket;
+    ConsoleState consoleState;
+    ConsoleMeters meters;
     ModOSCSender OSCSender;
-    ModOSCReceiver OSCReceiver;
-    juce::String IPAddress = "169.254.121.37";
-};
+    ModOSCReceiver OSCReceiver { consoleState, meters };
 
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCSetup)
+};
@@ -0,0 +1,296 @@
+/*
+  ==============================================================================
+
+    ParametricEqFitter.h
+    Created: 18 Oct 2026 9:17:05pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "X32EqModel.h"
+
+//==============================================================================
+// Fits up to X32Eq::numMainBands peaking bands so that the measured response
+// plus the EQ matches a target curve, in a weighted least-squares sense on
+// the dB scale. The bands are refined with Levenberg-Marquardt over their
+// OSC values (all bounded to 0..1), and the result is quantised to the
+// console's steps.
+//
+// Each band's response is cached: a Jacobian column only re-evaluates the
+// band it belongs to, so the Jacobian costs 3 kernel evaluations per band.
+class ParametricEqFitter
+{
+public:
+    struct Result
+    {
+        X32Eq::Band bands[X32Eq::numMainBands];
+        int numBands = 0;
+        float rmsErrorBefore = 0.0f; // Weighted, in dB
+        float rmsErrorAfter = 0.0f;
+        int iterations = 0;
+    };
+
+    enum { maxIterations = 100 };
+
+    ParametricEqFitter(const float* frequencies, int numPointsToUse)
+        : numPoints(numPointsToUse),
+        kernel(frequencies, numPointsToUse),
+        responses((size_t)(X32Eq::numMainBands * numPointsToUse)),
+        trial((size_t)numPointsToUse),
+        error((size_t)numPointsToUse),
+        jacobian((size_t)(numParams * numPointsToUse))
+    {
+    }
+
+    // Largest boost a band may apply. 0 (the default) fits cuts only, which
+    // is what the analyser wants for ringing and room modes.
+    void setMaxBoost(float dB) noexcept { maxBoostdB = juce::jlimit(0.0f, X32Eq::maxGaindB, dB); }
+
+    // measureddB, targetdB and weights have one value per point. Points with
+    // weight 0 are ignored. seeds are the starting bands, one per band to fit.
+    Result fit(const float* measureddB, const float* targetdB, const float* weights,
+               const X32Eq::Band* seeds, int numSeeds)
+    {
+        Result result;
+        numBands = juce::jlimit(0, (int)X32Eq::numMainBands, numSeeds);
+        measured = measureddB;
+        target = targetdB;
+        weight = weights;
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            auto seed = seeds[b];
+            seed.type = X32Eq::BandType::peq;
+            seed.gaindB = juce::jlimit(-X32Eq::maxGaindB, maxBoostdB, seed.gaindB);
+            setBand(params + 3 * b, seed);
+            kernel.getMagnitudedB(seed, response(b));
+        }
+
+        result.rmsErrorBefore = rmsError(measured);
+        float cost = evaluateCost();
+        float lambda = 1.0e-2f;
+
+        for (; result.iterations < maxIterations && numBands > 0; ++result.iterations)
+        {
+            buildJacobian();
+            if (!solveStep(lambda))
+                break;
+
+            // Try the step, keeping it inside the bounds
+            float saved[numParams];
+            std::copy(params, params + numParams, saved);
+            for (int j = 0; j < 3 * numBands; ++j)
+                params[j] = juce::jlimit(0.0f, upperBound(j), params[j] + step[j]);
+
+            for (int b = 0; b < numBands; ++b)
+                kernel.getMagnitudedB(getBand(params + 3 * b), response(b));
+
+            const float newCost = evaluateCost();
+
+            if (newCost < cost)
+            {
+                const bool converged = cost - newCost < 1.0e-6f * cost;
+                cost = newCost;
+                lambda = juce::jmax(1.0e-7f, lambda / 3.0f);
+                if (converged)
+                    break;
+            }
+            else
+            {
+                std::copy(saved, saved + numParams, params);
+                for (int b = 0; b < numBands; ++b)
+                    kernel.getMagnitudedB(getBand(params + 3 * b), response(b));
+                computeError(); // buildJacobian and solveStep need it for params
+
+                lambda *= 4.0f;
+                if (lambda > 1.0e7f)
+                    break;
+            }
+        }
+
+        // What the console will actually do
+        result.numBands = numBands;
+        for (int b = 0; b < numBands; ++b)
+        {
+            result.bands[b] = getBand(params + 3 * b).quantised();
+            kernel.getMagnitudedB(result.bands[b], response(b));
+        }
+
+        result.rmsErrorAfter = std::sqrt(evaluateCost() / juce::jmax(1.0e-9f, totalWeight()));
+        return result;
+    }
+
+private:
+    enum { numParams = 3 * X32Eq::numMainBands };
+
+    static constexpr float delta = 1.0e-3f; // Finite difference step, in OSC value
+
+    float* response(int band) noexcept { return responses.data() + band * numPoints; }
+
+    // params per band: frequency, Q and gain as OSC values
+    static void setBand(float* p, const X32Eq::Band& band) noexcept
+    {
+        p[0] = X32Eq::frequencyToValue(band.frequency);
+        p[1] = X32Eq::qToValue(band.q);
+        p[2] = X32Eq::gainToValue(band.gaindB);
+    }
+
+    static X32Eq::Band getBand(const float* p) noexcept
+    {
+        return { X32Eq::BandType::peq, X32Eq::valueToFrequency(p[0]), X32Eq::valueToQ(p[1]), X32Eq::valueToGain(p[2]) };
+    }
+
+    float upperBound(int param) const noexcept
+    {
+        return param % 3 == 2 ? X32Eq::gainToValue(maxBoostdB) : 1.0f;
+    }
+
+    // error = measured + sum of bands - target
+    void computeError() noexcept
+    {
+        juce::FloatVectorOperations::subtract(error.data(), measured, target, numPoints);
+        for (int b = 0; b < numBands; ++b)
+            juce::FloatVectorOperations::add(error.data(), response(b), numPoints);
+    }
+
+    float evaluateCost() noexcept
+    {
+        computeError();
+
+        float cost = 0.0f;
+        for (int i = 0; i < numPoints; ++i)
+            cost += weight[i] * error[(size_t)i] * error[(size_t)i];
+        return cost;
+    }
+
+    float totalWeight() const noexcept
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < numPoints; ++i)
+            sum += weight[i];
+        return sum;
+    }
+
+    float rmsError(const float* curve) const noexcept
+    {
+        float cost = 0.0f;
+        for (int i = 0; i < numPoints; ++i)
+            cost += weight[i] * (curve[i] - target[i]) * (curve[i] - target[i]);
+        return std::sqrt(cost / juce::jmax(1.0e-9f, totalWeight()));
+    }
+
+    // Forward differences, one band re-evaluated per column. Assumes error
+    // is up to date for the current params.
+    void buildJacobian() noexcept
+    {
+        for (int b = 0; b < numBands; ++b)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const int j = 3 * b + k;
+                float p[3] = { params[3 * b], params[3 * b + 1], params[3 * b + 2] };
+
+                // Step inwards at the upper bound
+                const float h = p[k] + delta > upperBound(j) ? -delta : delta;
+                p[k] += h;
+
+                kernel.getMagnitudedB(getBand(p), trial.data());
+                float* column = jacobian.data() + j * numPoints;
+                juce::FloatVectorOperations::subtract(column, trial.data(), response(b), numPoints);
+                juce::FloatVectorOperations::multiply(column, 1.0f / h, numPoints);
+            }
+        }
+    }
+
+    // Solves (JtWJ + lambda diag(JtWJ)) step = -JtWe by Cholesky. Returns
+    // false if the system is singular.
+    bool solveStep(float lambda) noexcept
+    {
+        const int n = 3 * numBands;
+        double a[numParams][numParams];
+        double g[numParams];
+
+        for (int r = 0; r < n; ++r)
+        {
+            const float* jr = jacobian.data() + r * numPoints;
+            g[r] = 0.0;
+            for (int i = 0; i < numPoints; ++i)
+                g[r] -= (double)(weight[i] * jr[i] * error[(size_t)i]);
+
+            for (int c = 0; c <= r; ++c)
+            {
+                const float* jc = jacobian.data() + c * numPoints;
+                double sum = 0.0;
+                for (int i = 0; i < numPoints; ++i)
+                    sum += (double)(weight[i] * jr[i] * jc[i]);
+                a[r][c] = a[c][r] = sum;
+            }
+        }
+
+        for (int r = 0; r < n; ++r)
+            a[r][r] = a[r][r] * (1.0 + lambda) + 1.0e-9;
+
+        // In-place Cholesky, lower triangle
+        for (int r = 0; r < n; ++r)
+        {
+            for (int c = 0; c <= r; ++c)
+            {
+                double sum = a[r][c];
+                for (int k = 0; k < c; ++k)
+                    sum -= a[r][k] * a[c][k];
+
+                if (r == c)
+                {
+                    if (sum <= 0.0)
+                        return false;
+                    a[r][r] = std::sqrt(sum);
+                }
+                else
+                {
+                    a[r][c] = sum / a[c][c];
+                }
+            }
+        }
+
+        // Forward then back substitution
+        for (int r = 0; r < n; ++r)
+        {
+            double sum = g[r];
+            for (int k = 0; k < r; ++k)
+                sum -= a[r][k] * g[k];
+            g[r] = sum / a[r][r];
+        }
+        for (int r = n - 1; r >= 0; --r)
+        {
+            double sum = g[r];
+            for (int k = r + 1; k < n; ++k)
+                sum -= a[k][r] * g[k];
+            g[r] = sum / a[r][r];
+        }
+
+        for (int r = 0; r < n; ++r)
+            step[r] = (float)g[r];
+        return true;
+    }
+
+    int numPoints;
+    int numBands = 0;
+    float maxBoostdB = 0.0f;
+    const float* measured = nullptr;
+    const float* target = nullptr;
+    const float* weight = nullptr;
+
+    X32Eq::MagnitudeKernel kernel;
+    std::vector<float> responses; // Current response of each band, in dB
+    std::vector<float> trial;
+    std::vector<float> error;
+    std::vector<float> jacobian;  // One column of numPoints per parameter
+    float params[numParams] {};
+    float step[numParams] {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEqFitter)
+};
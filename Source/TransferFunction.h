@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    TransferFunction.h
+    Created: 18 Oct 2026 5:02:27pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// H1 transfer function estimator. Each frame brings the reference auto
+// spectrum Gxx, the measurement auto spectrum Gyy and the complex cross
+// spectrum Gxy, already band-averaged onto the display points. The spectra
+// are averaged over frames and magnitude and phase are derived from the
+// averages: H1 = Gxy / Gxx. Uncorrelated noise in the measurement averages
+// out of Gxy instead of biasing every single frame.
+//
+// Gxy is summed as a complex value across each band, so the reference must
+// be time-aligned with the measurement (the console's output delays) before
+// it gets here. A residual delay turns the phase across a band, the bins
+// partly cancel, and both |H1| and the coherence read low in the wide bands
+// at high frequencies even when the system itself is linear.
+class TransferFunctionEstimator
+{
+public:
+    enum class Averaging
+    {
+        fifo,        // Mean of the last N frames
+        exponential, // Exponential average with time constant N frames
+        infinite     // Mean of every frame since the last change
+    };
+
+    static constexpr int maxAverageDepth = 128;
+
+    TransferFunctionEstimator(int numPointsToUse, int averageDepthToUse)
+        : numPoints(numPointsToUse),
+        ring((size_t)(maxAverageDepth * numQuantities * numPointsToUse), 0.0f),
+        sums((size_t)(numQuantities * numPointsToUse), 0.0),
+        averages((size_t)(numQuantities * numPointsToUse), 0.0f),
+        pendingDepth(averageDepthToUse)
+    {
+        applyPendingSettings();
+    }
+
+    // Any thread. The estimator restarts its average at the next frame.
+    void setAveraging(Averaging mode, int depth) noexcept
+    {
+        pendingDepth.store(juce::jlimit(1, maxAverageDepth, depth));
+        pendingMode.store(mode);
+    }
+
+    // Adds one frame of spectra and updates the averages. Frames go into a
+    // fixed ring with running sums, so this is O(points) with no allocation
+    // whatever the depth. Returns true when new averages are available.
+    bool addFrame(const float* gxx, const float* gyy, const float* gxyRe, const float* gxyIm)
+    {
+        if (pendingMode.load() != mode || pendingDepth.load() != depth)
+            applyPendingSettings();
+
+        const float* inputs[numQuantities] = { gxx, gyy, gxyRe, gxyIm };
+
+        if (mode == Averaging::exponential)
+        {
+            // Plain mean until the average is depth frames deep, so it doesn't
+            // start from zero
+            numFrames = juce::jmin(numFrames + 1, depth);
+            const float alpha = 1.0f / (float)numFrames;
+
+            for (int q = 0; q < numQuantities; ++q)
+            {
+                float* avg = averages.data() + q * numPoints;
+                for (int i = 0; i < numPoints; ++i)
+                    avg[i] += alpha * (inputs[q][i] - avg[i]);
+            }
+            return true;
+        }
+
+        float* slot = ring.data() + writeIndex * numQuantities * numPoints;
+        const bool full = (mode == Averaging::fifo && numFrames == depth);
+
+        for (int q = 0; q < numQuantities; ++q)
+        {
+            double* sum = sums.data() + q * numPoints;
+            float* oldest = slot + q * numPoints;
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                sum[i] += inputs[q][i];
+                if (full)
+                    sum[i] -= oldest[i];
+                oldest[i] = inputs[q][i];
+            }
+        }
+
+        if (mode == Averaging::fifo)
+        {
+            writeIndex = (writeIndex + 1) % depth;
+            numFrames = juce::jmin(numFrames + 1, depth);
+        }
+        else
+        {
+            ++numFrames;
+        }
+
+        const double scale = 1.0 / (double)numFrames;
+        for (size_t i = 0; i < averages.size(); ++i)
+            averages[i] = (float)(sums[i] * scale);
+
+        return true;
+    }
+
+    // |H1| mapped to the analyser's 0..1 display range, where 0.5 is 0 dB and
+    // the edges are -rangedB/+rangedB
+    void getMagnitude(float* dest, float rangedB) const noexcept
+    {
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const float gxy = std::hypot(avgGxyRe()[i], avgGxyIm()[i]);
+            const float dB = juce::Decibels::gainToDecibels(gxy / juce::jmax(avgGxx()[i], tiny));
+            dest[i] = juce::jlimit(0.0f, 1.0f, 0.5f + 0.5f * dB / rangedB);
+        }
+    }
+
+    // Phase of the measurement relative to the reference, in radians. It is
+    // taken from the averaged cross spectrum, i.e. the frames' phases are
+    // averaged as vectors, so frames either side of +-pi don't cancel out.
+    void getPhase(float* dest) const noexcept
+    {
+        for (int i = 0; i < numPoints; ++i)
+            dest[i] = std::atan2(avgGxyIm()[i], avgGxyRe()[i]);
+    }
+
+    // Magnitude-squared coherence |Gxy|^2 / (Gxx * Gyy), from 0 (measurement
+    // unrelated to the reference) to 1 (fully explained by it). Only
+    // meaningful once several frames have been averaged.
+    void getCoherence(float* dest) const noexcept
+    {
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const float gxy2 = avgGxyRe()[i] * avgGxyRe()[i] + avgGxyIm()[i] * avgGxyIm()[i];
+            dest[i] = juce::jlimit(0.0f, 1.0f, gxy2 / juce::jmax(avgGxx()[i] * avgGyy()[i], tiny));
+        }
+    }
+
+private:
+    static constexpr float tiny = 1.0e-20f;
+
+    enum { numQuantities = 4 }; // Gxx, Gyy, Re(Gxy), Im(Gxy)
+
+    void applyPendingSettings() noexcept
+    {
+        mode = pendingMode.load();
+        depth = pendingDepth.load();
+        numFrames = 0;
+        writeIndex = 0;
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(averages.begin(), averages.end(), 0.0f);
+    }
+
+    const float* avgGxx() const noexcept { return averages.data(); }
+    const float* avgGyy() const noexcept { return averages.data() + numPoints; }
+    const float* avgGxyRe() const noexcept { return averages.data() + 2 * numPoints; }
+    const float* avgGxyIm() const noexcept { return averages.data() + 3 * numPoints; }
+
+    int numPoints;
+    std::vector<float> ring;     // maxAverageDepth frames of all quantities
+    std::vector<double> sums;    // Running sums, double so they don't drift
+    std::vector<float> averages; // Current averages of all quantities
+    Averaging mode = Averaging::fifo;
+    int depth = 1;
+    int numFrames = 0;
+    int writeIndex = 0;
+    std::atomic<Averaging> pendingMode { Averaging::fifo };
+    std::atomic<int> pendingDepth;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransferFunctionEstimator)
+};
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 18 Oct 2026 12:31:08pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+
+//==============================================================================
+// Lock-free single-writer/single-reader triple buffer. The writer always has a
+// private slot to fill, the reader always has a private slot to look at, and
+// publish/update just swap indices with the shared middle slot. Neither side
+// ever blocks, and the reader always gets the most recent complete value.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // Writer side
+    T& getWriteBuffer() noexcept { return buffers[writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = shared.exchange(writeIndex | newDataBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader side. Returns true if a newer value was swapped in.
+    bool update() noexcept
+    {
+        if ((shared.load(std::memory_order_relaxed) & newDataBit) == 0)
+            return false;
+
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return buffers[readIndex]; }
+
+private:
+    enum
+    {
+        indexMask = 3,
+        newDataBit = 4
+    };
+
+    T buffers[3] {};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> shared { 2 };
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+};
@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    X32EqModel.h
+    Created: 18 Oct 2026 8:41:52pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Model of one band of the X32 parametric EQ as used on the main bus: the
+// parameter ranges and their OSC value mappings, the steps the console
+// quantises them to, and the biquad each band type corresponds to.
+namespace X32Eq
+{
+    // Values of /eq/N/type
+    enum class BandType
+    {
+        lowCut = 0,
+        lowShelf,
+        peq,
+        veq,
+        highShelf,
+        highCut
+    };
+
+    constexpr int numMainBands = 6;
+    constexpr double sampleRate = 48000.0;
+
+    constexpr float minFrequency = 20.0f;
+    constexpr float maxFrequency = 20000.0f;
+    constexpr float maxQ = 10.0f; // At OSC value 0
+    constexpr float minQ = 0.3f;  // At OSC value 1
+    constexpr float maxGaindB = 15.0f;
+
+    // Number of distinct values the console accepts for each parameter
+    constexpr int frequencySteps = 201;
+    constexpr int qSteps = 72;
+    constexpr int gainSteps = 121; // 0.25 dB
+
+    //==========================================================================
+    // OSC value (0..1) <-> physical value. Frequency and Q are logarithmic,
+    // gain is linear.
+    inline float valueToFrequency(float v) noexcept { return minFrequency * std::pow(maxFrequency / minFrequency, v); }
+    inline float frequencyToValue(float hz) noexcept { return juce::jlimit(0.0f, 1.0f, std::log(hz / minFrequency) / std::log(maxFrequency / minFrequency)); }
+
+    inline float valueToQ(float v) noexcept { return maxQ * std::pow(minQ / maxQ, v); }
+    inline float qToValue(float q) noexcept { return juce::jlimit(0.0f, 1.0f, std::log(q / maxQ) / std::log(minQ / maxQ)); }
+
+    inline float valueToGain(float v) noexcept { return (2.0f * v - 1.0f) * maxGaindB; }
+    inline float gainToValue(float dB) noexcept { return juce::jlimit(0.0f, 1.0f, 0.5f + 0.5f * dB / maxGaindB); }
+
+    // Rounds an OSC value to the nearest of the console's steps
+    inline float quantise(float v, int steps) noexcept
+    {
+        return (float)juce::roundToInt(juce::jlimit(0.0f, 1.0f, v) * (float)(steps - 1)) / (float)(steps - 1);
+    }
+
+    //==========================================================================
+    struct Band
+    {
+        BandType type = BandType::peq;
+        float frequency = 1000.0f;
+        float q = 2.0f;
+        float gaindB = 0.0f;
+
+        // The band as the console will actually apply it
+        Band quantised() const noexcept
+        {
+            return { type,
+                     valueToFrequency(quantise(frequencyToValue(frequency), frequencySteps)),
+                     valueToQ(quantise(qToValue(q), qSteps)),
+                     valueToGain(quantise(gainToValue(gaindB), gainSteps)) };
+        }
+
+        bool operator==(const Band& other) const noexcept
+        {
+            return type == other.type && frequency == other.frequency && q == other.q && gaindB == other.gaindB;
+        }
+
+        bool operator!=(const Band& other) const noexcept { return !operator==(other); }
+    };
+
+    // Biquad coefficients, normalised so that a0 = 1
+    struct Coefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    // Audio EQ cookbook designs at the console's sample rate. The cuts are
+    // fixed 12 dB/oct Butterworth filters and ignore Q and gain. VEQ is
+    // modelled as a proportional-Q peak, narrowing as the gain grows.
+    inline Coefficients makeCoefficients(const Band& band) noexcept
+    {
+        const double w0 = juce::MathConstants<double>::twoPi * juce::jlimit(1.0, sampleRate * 0.49, (double)band.frequency) / sampleRate;
+        const double cosW0 = std::cos(w0);
+        const double A = std::pow(10.0, band.gaindB / 40.0);
+
+        double q = band.q;
+        if (band.type == BandType::lowCut || band.type == BandType::highCut)
+            q = juce::MathConstants<double>::sqrt2 * 0.5;
+        else if (band.type == BandType::veq)
+            q *= std::pow(10.0, std::abs(band.gaindB) / 40.0);
+
+        const double alpha = std::sin(w0) / (2.0 * q);
+        double b0, b1, b2, a0, a1, a2;
+
+        switch (band.type)
+        {
+            case BandType::lowCut:
+                b0 = (1.0 + cosW0) * 0.5; b1 = -(1.0 + cosW0); b2 = b0;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+                break;
+
+            case BandType::highCut:
+                b0 = (1.0 - cosW0) * 0.5; b1 = 1.0 - cosW0; b2 = b0;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+                break;
+
+            case BandType::lowShelf:
+            {
+                const double s = 2.0 * std::sqrt(A) * alpha;
+                b0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + s);
+                b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+                b2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - s);
+                a0 = (A + 1.0) + (A - 1.0) * cosW0 + s;
+                a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+                a2 = (A + 1.0) + (A - 1.0) * cosW0 - s;
+                break;
+            }
+
+            case BandType::highShelf:
+            {
+                const double s = 2.0 * std::sqrt(A) * alpha;
+                b0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + s);
+                b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+                b2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - s);
+                a0 = (A + 1.0) - (A - 1.0) * cosW0 + s;
+                a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+                a2 = (A + 1.0) - (A - 1.0) * cosW0 - s;
+                break;
+            }
+
+            case BandType::peq:
+            case BandType::veq:
+            default:
+                b0 = 1.0 + alpha * A; b1 = -2.0 * cosW0; b2 = 1.0 - alpha * A;
+                a0 = 1.0 + alpha / A; a1 = -2.0 * cosW0; a2 = 1.0 - alpha / A;
+                break;
+        }
+
+        return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+    }
+
+    //==========================================================================
+    // Evaluates band magnitudes on a fixed set of frequencies. With
+    // phi = sin^2(w/2), |H|^2 of a biquad is the ratio of two quadratics in
+    // phi, whose coefficients are computed once per band in double. The
+    // per-frequency work is then two multiply-adds per polynomial over
+    // precomputed phi and phi^2 tables, done with FloatVectorOperations,
+    // and this form stays accurate at low frequencies where expanding in
+    // cos(w) cancels out.
+    class MagnitudeKernel
+    {
+    public:
+        MagnitudeKernel(const float* frequencies, int numFrequenciesToUse)
+            : numFrequencies(numFrequenciesToUse),
+            phi((size_t)numFrequenciesToUse), phi2((size_t)numFrequenciesToUse),
+            numerator((size_t)numFrequenciesToUse), denominator((size_t)numFrequenciesToUse)
+        {
+            for (int i = 0; i < numFrequencies; ++i)
+            {
+                const double s = std::sin(juce::MathConstants<double>::pi * frequencies[i] / sampleRate);
+                phi[(size_t)i] = (float)(s * s);
+                phi2[(size_t)i] = (float)(s * s * s * s);
+            }
+        }
+
+        int getNumFrequencies() const noexcept { return numFrequencies; }
+
+        // Writes the band's magnitude in dB at every frequency into dest
+        void getMagnitudedB(const Band& band, float* dest) noexcept
+        {
+            const auto c = makeCoefficients(band);
+
+            evaluate(numerator.data(), c.b0, c.b1, c.b2);
+            evaluate(denominator.data(), 1.0, c.a1, c.a2);
+
+            for (int i = 0; i < numFrequencies; ++i)
+                dest[i] = 10.0f * std::log10(juce::jmax(numerator[(size_t)i], tiny) / juce::jmax(denominator[(size_t)i], tiny));
+        }
+
+    private:
+        static constexpr float tiny = 1.0e-30f;
+
+        // (c0 + c1 + c2)^2 - 4 (c0 c1 + 4 c0 c2 + c1 c2) phi + 16 c0 c2 phi^2
+        void evaluate(float* dest, double c0, double c1, double c2) noexcept
+        {
+            const double sum = c0 + c1 + c2;
+            juce::FloatVectorOperations::fill(dest, (float)(sum * sum), numFrequencies);
+            juce::FloatVectorOperations::addWithMultiply(dest, phi.data(), (float)(-4.0 * (c0 * c1 + 4.0 * c0 * c2 + c1 * c2)), numFrequencies);
+            juce::FloatVectorOperations::addWithMultiply(dest, phi2.data(), (float)(16.0 * c0 * c2), numFrequencies);
+        }
+
+        int numFrequencies;
+        std::vector<float> phi, phi2;
+        std::vector<float> numerator, denominator;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MagnitudeKernel)
+    };
+
+    //==========================================================================
+    // Combined magnitude and phase of the whole main bus EQ on a fixed set of
+    // frequencies, e.g. the analyser's display points. Each band's
+    // contribution is cached, so changing one band only recomputes that
+    // band; the totals are summed again lazily when asked for.
+    class ResponseModel
+    {
+    public:
+        ResponseModel(const float* frequencies, int numFrequenciesToUse)
+            : numFrequencies(numFrequenciesToUse),
+            kernel(frequencies, numFrequenciesToUse),
+            cosW((size_t)numFrequenciesToUse), sinW((size_t)numFrequenciesToUse),
+            cos2W((size_t)numFrequenciesToUse), sin2W((size_t)numFrequenciesToUse),
+            bandMagnitude((size_t)(numMainBands * numFrequenciesToUse)),
+            bandPhase((size_t)(numMainBands * numFrequenciesToUse)),
+            magnitude((size_t)numFrequenciesToUse), phase((size_t)numFrequenciesToUse)
+        {
+            for (int i = 0; i < numFrequencies; ++i)
+            {
+                const double w = juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate;
+                cosW[(size_t)i] = std::cos(w);
+                sinW[(size_t)i] = std::sin(w);
+                cos2W[(size_t)i] = std::cos(2.0 * w);
+                sin2W[(size_t)i] = std::sin(2.0 * w);
+            }
+        }
+
+        int getNumFrequencies() const noexcept { return numFrequencies; }
+
+        // index is 0-based. Does nothing if the band is already set to this.
+        void setBand(int index, const Band& band)
+        {
+            jassert(juce::isPositiveAndBelow(index, (int)numMainBands));
+
+            if (enabled[index] && bands[index] == band)
+                return;
+
+            bands[index] = band;
+            enabled[index] = true;
+            dirty = true;
+
+            kernel.getMagnitudedB(band, bandMagnitude.data() + index * numFrequencies);
+            computePhase(makeCoefficients(band), bandPhase.data() + index * numFrequencies);
+        }
+
+        // Takes the band out of the response, as if flat
+        void clearBand(int index) noexcept
+        {
+            jassert(juce::isPositiveAndBelow(index, (int)numMainBands));
+
+            dirty = dirty || enabled[index];
+            enabled[index] = false;
+        }
+
+        void clear() noexcept
+        {
+            for (int i = 0; i < numMainBands; ++i)
+                clearBand(i);
+        }
+
+        // Sum of the enabled bands, in dB
+        const float* getMagnitudedB() noexcept
+        {
+            update();
+            return magnitude.data();
+        }
+
+        // Sum of the enabled bands, in radians, not wrapped to +-pi
+        const float* getPhase() noexcept
+        {
+            update();
+            return phase.data();
+        }
+
+    private:
+        // arg B(e^jw) - arg A(e^jw)
+        void computePhase(const Coefficients& c, float* dest) const noexcept
+        {
+            for (int i = 0; i < numFrequencies; ++i)
+            {
+                const size_t n = (size_t)i;
+                const double bRe = c.b0 + c.b1 * cosW[n] + c.b2 * cos2W[n];
+                const double bIm = -(c.b1 * sinW[n] + c.b2 * sin2W[n]);
+                const double aRe = 1.0 + c.a1 * cosW[n] + c.a2 * cos2W[n];
+                const double aIm = -(c.a1 * sinW[n] + c.a2 * sin2W[n]);
+                dest[i] = (float)std::atan2(bIm * aRe - bRe * aIm, bRe * aRe + bIm * aIm);
+            }
+        }
+
+        void update() noexcept
+        {
+            if (!dirty)
+                return;
+
+            juce::FloatVectorOperations::clear(magnitude.data(), numFrequencies);
+            juce::FloatVectorOperations::clear(phase.data(), numFrequencies);
+
+            for (int b = 0; b < numMainBands; ++b)
+            {
+                if (!enabled[b])
+                    continue;
+
+                juce::FloatVectorOperations::add(magnitude.data(), bandMagnitude.data() + b * numFrequencies, numFrequencies);
+                juce::FloatVectorOperations::add(phase.data(), bandPhase.data() + b * numFrequencies, numFrequencies);
+            }
+
+            dirty = false;
+        }
+
+        int numFrequencies;
+        MagnitudeKernel kernel;
+        std::vector<double> cosW, sinW, cos2W, sin2W;
+        std::vector<float> bandMagnitude; // Cached per band, numFrequencies each
+        std::vector<float> bandPhase;
+        std::vector<float> magnitude;
+        std::vector<float> phase;
+        Band bands[numMainBands];
+        bool enabled[numMainBands] {};
+        bool dirty = true;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseModel)
+    };
+}
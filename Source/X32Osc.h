@@ -0,0 +1,437 @@
+/*
+  ==============================================================================
+
+    X32Osc.h
+    Created: 18 Oct 2026 10:52:37pm
+    Author:  josep
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "X32EqModel.h"
+
+//==============================================================================
+// Every X32 OSC address the tool talks to, validated and serialised once at
+// startup, with the argument type the console uses for it, plus an encoder
+// that writes messages and bundles straight into a caller's buffer. Sending
+// a message this way costs no string building, no pattern parsing and no
+// heap allocation.
+namespace X32Osc
+{
+    enum
+    {
+        maxAddressSize = 32,  // Serialised, padding included
+        maxPacketSize = 1024
+    };
+
+    // Parameter IDs. The ranges at the end hold one ID per band or parameter.
+    enum Id
+    {
+        info,
+        status,
+        xremote,    // Asks the console to push every change for 10 s
+        meters,     // Subscribes to a meter stream for 10 s
+        meters1,    // Input channels
+        meters2,    // Buses, matrices, main and mono
+        mainFader,
+        mainOn,
+        ch01Fader,
+        ch02Fader,
+        ch02On,
+        ch02Source,
+        ch02Trim,
+        bus12Fader,
+        bus12On,
+        out01Source,
+        out02Source,
+        out01DelayOn,
+        out02DelayOn,
+        out01DelayTime,
+        out02DelayTime,
+        oscLevel,
+        oscType,
+        oscDest,
+        statOscOn,
+        cardRouting,
+        mainEq,                     // 6 bands of { type, f, q, g }
+        ch01EqGain = mainEq + 6 * 4, // 4 bands
+        ch02EqGain = ch01EqGain + 4, // 4 bands
+        fx8Par = ch02EqGain + 4,     // /fx/8/par/00 to /fx/8/par/31
+        numIds = fx8Par + 32
+    };
+
+    enum EqField { eqType, eqFrequency, eqQ, eqGain };
+
+    // band is 1-based, as in the address
+    inline Id mainEqId(int band, EqField field) noexcept
+    {
+        jassert(band >= 1 && band <= 6);
+        return (Id)(mainEq + (band - 1) * 4 + field);
+    }
+
+    // channel 1 or 2, band 1-based
+    inline Id channelEqGainId(int channel, int band) noexcept
+    {
+        jassert((channel == 1 || channel == 2) && band >= 1 && band <= 4);
+        return (Id)((channel == 1 ? ch01EqGain : ch02EqGain) + band - 1);
+    }
+
+    inline Id fx8ParId(int parameter) noexcept
+    {
+        jassert(parameter >= 0 && parameter < 32);
+        return (Id)(fx8Par + parameter);
+    }
+
+    //==========================================================================
+    // How each parameter is sent. Floats go out as the console's 0..1 value:
+    // level is that value as is, linear and logarithmic map a physical value
+    // between the one at 0 and the one at 1.
+    enum class Type
+    {
+        none,       // Commands and read-only values, no value is stored
+        integer,    // Enums, switches and routing indices
+        level,
+        linear,
+        logarithmic,
+        blob        // Meter streams
+    };
+
+    struct ParameterInfo
+    {
+        Type type;
+        float atZero = 0.0f;
+        float atOne = 1.0f;
+    };
+
+    constexpr ParameterInfo getParameterInfo(Id id) noexcept
+    {
+        if (id >= fx8Par)
+            return { Type::level };
+        if (id >= ch01EqGain)
+            return { Type::linear, -X32Eq::maxGaindB, X32Eq::maxGaindB };
+        if (id >= mainEq)
+        {
+            switch ((id - mainEq) % 4)
+            {
+                case eqType:      return { Type::integer };
+                case eqFrequency: return { Type::logarithmic, X32Eq::minFrequency, X32Eq::maxFrequency };
+                case eqQ:         return { Type::logarithmic, X32Eq::maxQ, X32Eq::minQ };
+                default:          return { Type::linear, -X32Eq::maxGaindB, X32Eq::maxGaindB };
+            }
+        }
+
+        switch (id)
+        {
+            case info:
+            case status:
+            case xremote:
+            case meters:
+                return { Type::none };
+
+            case meters1:
+            case meters2:
+                return { Type::blob };
+
+            case mainFader:
+            case ch01Fader:
+            case ch02Fader:
+            case bus12Fader:
+            case oscLevel:
+                return { Type::level };
+
+            case ch02Trim:
+                return { Type::linear, -18.0f, 18.0f };        // dB
+
+            case out01DelayTime:
+            case out02DelayTime:
+                return { Type::linear, 0.2f, 500.2f };         // ms
+
+            default:
+                return { Type::integer };
+        }
+    }
+
+    static_assert(getParameterInfo((Id)(mainEq + eqFrequency)).type == Type::logarithmic, "EQ frequency is logarithmic");
+    static_assert(getParameterInfo(cardRouting).type == Type::integer, "Routing is an index");
+
+    // Physical value -> OSC value, clipped to 0..1
+    inline float toValue(Id id, float physical) noexcept
+    {
+        const auto info = getParameterInfo(id);
+
+        switch (info.type)
+        {
+            case Type::level:
+                return juce::jlimit(0.0f, 1.0f, physical);
+            case Type::linear:
+                return juce::jlimit(0.0f, 1.0f, (physical - info.atZero) / (info.atOne - info.atZero));
+            case Type::logarithmic:
+                return juce::jlimit(0.0f, 1.0f, std::log(physical / info.atZero) / std::log(info.atOne / info.atZero));
+            default:
+                jassertfalse; // Not a float parameter
+                return 0.0f;
+        }
+    }
+
+    // The X32 fader law: dB -> level, -90 dB and below is 0, +10 dB is 1
+    inline float faderLevel(float dB) noexcept
+    {
+        float level;
+        if (dB < -60.0f)      level = (dB + 90.0f) / 480.0f;
+        else if (dB < -30.0f) level = (dB + 70.0f) / 160.0f;
+        else if (dB < -10.0f) level = (dB + 50.0f) / 80.0f;
+        else                  level = (dB + 30.0f) / 40.0f;
+
+        return juce::jlimit(0.0f, 1.0f, level);
+    }
+
+    // Only used to build the table
+    inline juce::String getAddress(Id id)
+    {
+        if (id >= fx8Par)
+            return "/fx/8/par/" + juce::String(id - fx8Par).paddedLeft('0', 2);
+        if (id >= ch02EqGain)
+            return "/ch/02/eq/" + juce::String(id - ch02EqGain + 1) + "/g";
+        if (id >= ch01EqGain)
+            return "/ch/01/eq/" + juce::String(id - ch01EqGain + 1) + "/g";
+        if (id >= mainEq)
+        {
+            const char* fields[] = { "type", "f", "q", "g" };
+            return "/main/st/eq/" + juce::String((id - mainEq) / 4 + 1) + "/" + fields[(id - mainEq) % 4];
+        }
+
+        switch (id)
+        {
+            case info:           return "/info";
+            case status:         return "/status";
+            case xremote:        return "/xremote";
+            case meters:         return "/meters";
+            case meters1:        return "/meters/1";
+            case meters2:        return "/meters/2";
+            case mainFader:      return "/main/st/mix/fader";
+            case mainOn:         return "/main/st/mix/on";
+            case ch01Fader:      return "/ch/01/mix/fader";
+            case ch02Fader:      return "/ch/02/mix/fader";
+            case ch02On:         return "/ch/02/mix/on";
+            case ch02Source:     return "/ch/02/source";
+            case ch02Trim:       return "/ch/02/preamp/trim";
+            case bus12Fader:     return "/bus/12/mix/fader";
+            case bus12On:        return "/bus/12/mix/on";
+            case out01Source:    return "/outputs/main/01/src";
+            case out02Source:    return "/outputs/main/02/src";
+            case out01DelayOn:   return "/outputs/main/01/delay/on";
+            case out02DelayOn:   return "/outputs/main/02/delay/on";
+            case out01DelayTime: return "/outputs/main/01/delay/time";
+            case out02DelayTime: return "/outputs/main/02/delay/time";
+            case oscLevel:       return "/config/osc/level";
+            case oscType:        return "/config/osc/type";
+            case oscDest:        return "/config/osc/dest";
+            case statOscOn:      return "/-stat/osc/on";
+            case cardRouting:    return "/config/routing/CARD/1-8";
+            default:             break;
+        }
+
+        jassertfalse;
+        return {};
+    }
+
+    //==========================================================================
+    // An address as it goes on the wire: null terminated, padded to 4 bytes
+    struct EncodedAddress
+    {
+        char bytes[maxAddressSize] {};
+        int size = 0;
+    };
+
+    // A plain address, no pattern characters, that fits the table
+    inline bool isValidAddress(const char* address) noexcept
+    {
+        if (address[0] != '/' || std::strlen(address) + 1 > maxAddressSize)
+            return false;
+
+        for (auto c = address; *c != 0; ++c)
+            if (*c <= ' ' || *c > '~' || std::strchr("#*,?[]{}", *c) != nullptr)
+                return false;
+
+        return true;
+    }
+
+    class AddressTable
+    {
+    public:
+        static const AddressTable& getInstance()
+        {
+            static const AddressTable table;
+            return table;
+        }
+
+        const EncodedAddress& operator[](Id id) const noexcept { return addresses[id]; }
+
+        // Looks up the ID of a received address. Binary search, so it can
+        // run on the network thread for every message.
+        bool find(const char* address, Id& result) const noexcept
+        {
+            auto found = std::lower_bound(std::begin(sorted), std::end(sorted), address,
+                                          [this](int id, const char* a) { return std::strcmp(addresses[id].bytes, a) < 0; });
+
+            if (found == std::end(sorted) || std::strcmp(addresses[*found].bytes, address) != 0)
+                return false;
+
+            result = (Id)*found;
+            return true;
+        }
+
+    private:
+        AddressTable()
+        {
+            for (int id = 0; id < numIds; ++id)
+            {
+                const auto address = getAddress((Id)id);
+                const char* text = address.toRawUTF8();
+                jassert(isValidAddress(text));
+
+                auto& encoded = addresses[id];
+                std::strncpy(encoded.bytes, text, maxAddressSize - 1);
+                encoded.size = ((int)std::strlen(encoded.bytes) + 4) & ~3;
+                sorted[id] = id;
+            }
+
+            std::sort(std::begin(sorted), std::end(sorted),
+                      [this](int a, int b) { return std::strcmp(addresses[a].bytes, addresses[b].bytes) < 0; });
+        }
+
+        EncodedAddress addresses[numIds];
+        int sorted[numIds];                 // IDs in address order
+    };
+
+    //==========================================================================
+    // One message: an ID and at most one argument
+    struct Message
+    {
+        Id id = info;
+        char type = 0; // 'f', 'i', 's', or 0 for a query with no argument
+        float floatValue = 0.0f;
+        juce::int32 intValue = 0;
+        Id textId = info; // For 's': the argument is this ID's address
+
+        static Message query(Id id) noexcept { Message m; m.id = id; return m; }
+        static Message withFloat(Id id, float value) noexcept { Message m; m.id = id; m.type = 'f'; m.floatValue = value; return m; }
+        static Message withInt(Id id, int value) noexcept { Message m; m.id = id; m.type = 'i'; m.intValue = value; return m; }
+        static Message withAddress(Id id, Id argument) noexcept { Message m; m.id = id; m.type = 's'; m.textId = argument; return m; }
+
+        // A float parameter in the physical units of its table entry
+        static Message withPhysical(Id id, float physical) noexcept
+        {
+            return withFloat(id, toValue(id, physical));
+        }
+
+        static Message withInteger(Id id, int value) noexcept
+        {
+            jassert(getParameterInfo(id).type == Type::integer);
+            return withInt(id, value);
+        }
+    };
+
+    // Serialises messages, or a bundle of them, into a fixed buffer. Every
+    // write returns false, and leaves the packet as it was, if it doesn't fit.
+    class PacketWriter
+    {
+    public:
+        PacketWriter(char* bufferToUse, int capacityToUse) noexcept
+            : buffer(bufferToUse), capacity(capacityToUse) {}
+
+        void reset() noexcept { size = 0; }
+        int getSize() const noexcept { return size; }
+        const char* getData() const noexcept { return buffer; }
+
+        bool writeMessage(const Message& message) noexcept
+        {
+            const int start = size;
+            if (writeMessageBody(message))
+                return true;
+
+            size = start;
+            return false;
+        }
+
+        // "#bundle", then a time tag of 1, i.e. "immediately"
+        bool beginBundle() noexcept
+        {
+            reset();
+            return writeBytes("#bundle", 8) && writeInt32(0) && writeInt32(1);
+        }
+
+        bool addToBundle(const Message& message) noexcept
+        {
+            const int start = size;
+
+            if (writeInt32(0) && writeMessageBody(message))
+            {
+                juce::ByteOrder::writeBigEndianInt(buffer + start, (juce::uint32)(size - start - 4));
+                return true;
+            }
+
+            size = start;
+            return false;
+        }
+
+    private:
+        bool writeMessageBody(const Message& message) noexcept
+        {
+            const auto& address = AddressTable::getInstance()[message.id];
+            if (!writeBytes(address.bytes, address.size))
+                return false;
+
+            const char tags[4] = { ',', message.type, 0, 0 };
+            if (!writeBytes(tags, 4))
+                return false;
+
+            switch (message.type)
+            {
+                case 'f':
+                {
+                    juce::uint32 bits;
+                    std::memcpy(&bits, &message.floatValue, sizeof(bits));
+                    return writeInt32(bits);
+                }
+                case 'i':
+                    return writeInt32((juce::uint32)message.intValue);
+                case 's':
+                {
+                    const auto& text = AddressTable::getInstance()[message.textId];
+                    return writeBytes(text.bytes, text.size);
+                }
+                default:
+                    return true;
+            }
+        }
+
+        bool writeInt32(juce::uint32 value) noexcept
+        {
+            if (size + 4 > capacity)
+                return false;
+
+            juce::ByteOrder::writeBigEndianInt(buffer + size, value);
+            size += 4;
+            return true;
+        }
+
+        // Copies numBytes from data, which must already include any padding
+        bool writeBytes(const char* data, int numBytes) noexcept
+        {
+            if (size + numBytes > capacity)
+                return false;
+
+            std::memcpy(buffer + size, data, (size_t)numBytes);
+            size += numBytes;
+            return true;
+        }
+
+        char* buffer;
+        int capacity;
+        int size = 0;
+    };
+}